@@ -14156,1215 +14156,121 @@ static const char be00[382] =
     "\000\201z\000\201{\000\201|\000\201}\000\201~\000\201";
 static const char bdefault[4] = "\000\000\000\200";
 
+/* Dense page index from block number to block, generated from the block list above. Blocks
+ * with no transliterations point at bdefault, so a lookup is one bounds check and one load.
+ * The index and the blocks are both laid out in block number order, which keeps the
+ * commonly hit BMP blocks (Latin, Cyrillic, Kana, CJK) together at the front. */
+static const char *const blocks[0x321] = {
+    b000, b001, b002, b003, b004, b005, b006, b007,
+    b008, b009, b00a, b00b, b00c, b00d, b00e, b00f,
+    b010, b011, b012, b013, b014, b015, b016, b017,
+    b018, b019, b01a, b01b, b01c, b01d, b01e, b01f,
+    b020, b021, b022, b023, b024, b025, b026, b027,
+    b028, b029, b02a, b02b, b02c, b02d, b02e, b02f,
+    b030, b031, b032, b033, b034, b035, b036, b037,
+    b038, b039, b03a, b03b, b03c, b03d, b03e, b03f,
+    b040, b041, b042, b043, b044, b045, b046, b047,
+    b048, b049, b04a, b04b, b04c, b04d, b04e, b04f,
+    b050, b051, b052, b053, b054, b055, b056, b057,
+    b058, b059, b05a, b05b, b05c, b05d, b05e, b05f,
+    b060, b061, b062, b063, b064, b065, b066, b067,
+    b068, b069, b06a, b06b, b06c, b06d, b06e, b06f,
+    b070, b071, b072, b073, b074, b075, b076, b077,
+    b078, b079, b07a, b07b, b07c, b07d, b07e, b07f,
+    b080, b081, b082, b083, b084, b085, b086, b087,
+    b088, b089, b08a, b08b, b08c, b08d, b08e, b08f,
+    b090, b091, b092, b093, b094, b095, b096, b097,
+    b098, b099, b09a, b09b, b09c, b09d, b09e, b09f,
+    b0a0, b0a1, b0a2, b0a3, b0a4, b0a5, b0a6, b0a7,
+    b0a8, b0a9, b0aa, b0ab, b0ac, b0ad, b0ae, b0af,
+    b0b0, b0b1, b0b2, b0b3, b0b4, b0b5, b0b6, b0b7,
+    b0b8, b0b9, b0ba, b0bb, b0bc, b0bd, b0be, b0bf,
+    b0c0, b0c1, b0c2, b0c3, b0c4, b0c5, b0c6, b0c7,
+    b0c8, b0c9, b0ca, b0cb, b0cc, b0cd, b0ce, b0cf,
+    b0d0, b0d1, b0d2, b0d3, b0d4, b0d5, b0d6, b0d7,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, b0f9, b0fa, b0fb, b0fc, b0fd, b0fe, b0ff,
+    b100, b101, b102, b103, b104, b105, b106, b107,
+    b108, b109, b10a, b10b, b10c, b10d, b10e, b10f,
+    b110, b111, b112, b113, b114, b115, b116, b117,
+    b118, b119, b11a, b11b, b11c, b11d, b11e, b11f,
+    bdefault, bdefault, bdefault, bdefault, b124, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, b12f,
+    b130, b131, b132, b133, b134, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, b144, b145, b146, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, b16a, b16b, bdefault, bdefault, b16e, b16f,
+    b170, b171, b172, b173, b174, b175, b176, b177,
+    b178, b179, b17a, b17b, b17c, b17d, b17e, b17f,
+    b180, b181, b182, b183, b184, b185, b186, b187,
+    b188, b189, b18a, b18b, b18c, b18d, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    b1b0, b1b1, b1b2, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, b1bc, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, b1cf,
+    b1d0, b1d1, b1d2, b1d3, b1d4, b1d5, b1d6, b1d7,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, b1df,
+    b1e0, b1e1, b1e2, bdefault, b1e4, bdefault, bdefault, b1e7,
+    b1e8, b1e9, bdefault, bdefault, b1ec, b1ed, b1ee, bdefault,
+    b1f0, b1f1, b1f2, b1f3, b1f4, b1f5, b1f6, b1f7,
+    b1f8, b1f9, b1fa, b1fb, bdefault, bdefault, bdefault, bdefault,
+    b200, b201, b202, b203, b204, b205, b206, b207,
+    b208, b209, b20a, b20b, b20c, b20d, b20e, b20f,
+    b210, b211, b212, b213, b214, b215, b216, b217,
+    b218, b219, b21a, b21b, b21c, b21d, b21e, b21f,
+    b220, b221, b222, b223, b224, b225, b226, b227,
+    b228, b229, b22a, b22b, b22c, b22d, b22e, b22f,
+    b230, b231, b232, b233, b234, b235, b236, b237,
+    b238, b239, b23a, b23b, b23c, b23d, b23e, b23f,
+    b240, b241, b242, b243, b244, b245, b246, b247,
+    b248, b249, b24a, b24b, b24c, b24d, b24e, b24f,
+    b250, b251, b252, b253, b254, b255, b256, b257,
+    b258, b259, b25a, b25b, b25c, b25d, b25e, b25f,
+    b260, b261, b262, b263, b264, b265, b266, b267,
+    b268, b269, b26a, b26b, b26c, b26d, b26e, b26f,
+    b270, b271, b272, b273, b274, b275, b276, b277,
+    b278, b279, b27a, b27b, b27c, b27d, b27e, b27f,
+    b280, b281, b282, b283, b284, b285, b286, b287,
+    b288, b289, b28a, b28b, b28c, b28d, b28e, b28f,
+    b290, b291, b292, b293, b294, b295, b296, b297,
+    b298, b299, b29a, b29b, b29c, b29d, b29e, b29f,
+    b2a0, b2a1, b2a2, b2a3, b2a4, b2a5, b2a6, b2a7,
+    b2a8, b2a9, b2aa, b2ab, b2ac, b2ad, b2ae, b2af,
+    b2b0, b2b1, b2b2, b2b3, b2b4, b2b5, b2b6, b2b7,
+    b2b8, b2b9, b2ba, b2bb, b2bc, b2bd, b2be, b2bf,
+    b2c0, b2c1, b2c2, b2c3, b2c4, b2c5, b2c6, b2c7,
+    b2c8, b2c9, b2ca, b2cb, b2cc, b2cd, b2ce, b2cf,
+    b2d0, b2d1, b2d2, b2d3, bdefault, b2d5, b2d6, b2d7,
+    b2d8, b2d9, b2da, b2db, b2dc, b2dd, b2de, bdefault,
+    b2e0, b2e1, b2e2, b2e3, b2e4, b2e5, b2e6, b2e7,
+    b2e8, b2e9, b2ea, b2eb, bdefault, bdefault, bdefault, bdefault,
+    bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault, bdefault,
+    b2f8, b2f9, b2fa, bdefault, bdefault, bdefault, bdefault, bdefault,
+    b300, b301, b302, b303, b304, b305, b306, b307,
+    b308, b309, b30a, b30b, b30c, b30d, b30e, b30f,
+    b310, b311, b312, b313, b314, b315, b316, b317,
+    b318, b319, bdefault, bdefault, bdefault, bdefault, bdefault, b31f,
+    b320,
+};
+
 static const char *block(uint_least32_t blocknum)
 {
-    switch (blocknum)
-    {
-    case 0x000:
-        return b000;
-    case 0x001:
-        return b001;
-    case 0x002:
-        return b002;
-    case 0x003:
-        return b003;
-    case 0x004:
-        return b004;
-    case 0x005:
-        return b005;
-    case 0x006:
-        return b006;
-    case 0x007:
-        return b007;
-    case 0x008:
-        return b008;
-    case 0x009:
-        return b009;
-    case 0x00a:
-        return b00a;
-    case 0x00b:
-        return b00b;
-    case 0x00c:
-        return b00c;
-    case 0x00d:
-        return b00d;
-    case 0x00e:
-        return b00e;
-    case 0x00f:
-        return b00f;
-    case 0x010:
-        return b010;
-    case 0x011:
-        return b011;
-    case 0x012:
-        return b012;
-    case 0x013:
-        return b013;
-    case 0x014:
-        return b014;
-    case 0x015:
-        return b015;
-    case 0x016:
-        return b016;
-    case 0x017:
-        return b017;
-    case 0x018:
-        return b018;
-    case 0x019:
-        return b019;
-    case 0x01a:
-        return b01a;
-    case 0x01b:
-        return b01b;
-    case 0x01c:
-        return b01c;
-    case 0x01d:
-        return b01d;
-    case 0x01e:
-        return b01e;
-    case 0x01f:
-        return b01f;
-    case 0x020:
-        return b020;
-    case 0x021:
-        return b021;
-    case 0x022:
-        return b022;
-    case 0x023:
-        return b023;
-    case 0x024:
-        return b024;
-    case 0x025:
-        return b025;
-    case 0x026:
-        return b026;
-    case 0x027:
-        return b027;
-    case 0x028:
-        return b028;
-    case 0x029:
-        return b029;
-    case 0x02a:
-        return b02a;
-    case 0x02b:
-        return b02b;
-    case 0x02c:
-        return b02c;
-    case 0x02d:
-        return b02d;
-    case 0x02e:
-        return b02e;
-    case 0x02f:
-        return b02f;
-    case 0x030:
-        return b030;
-    case 0x031:
-        return b031;
-    case 0x032:
-        return b032;
-    case 0x033:
-        return b033;
-    case 0x034:
-        return b034;
-    case 0x035:
-        return b035;
-    case 0x036:
-        return b036;
-    case 0x037:
-        return b037;
-    case 0x038:
-        return b038;
-    case 0x039:
-        return b039;
-    case 0x03a:
-        return b03a;
-    case 0x03b:
-        return b03b;
-    case 0x03c:
-        return b03c;
-    case 0x03d:
-        return b03d;
-    case 0x03e:
-        return b03e;
-    case 0x03f:
-        return b03f;
-    case 0x040:
-        return b040;
-    case 0x041:
-        return b041;
-    case 0x042:
-        return b042;
-    case 0x043:
-        return b043;
-    case 0x044:
-        return b044;
-    case 0x045:
-        return b045;
-    case 0x046:
-        return b046;
-    case 0x047:
-        return b047;
-    case 0x048:
-        return b048;
-    case 0x049:
-        return b049;
-    case 0x04a:
-        return b04a;
-    case 0x04b:
-        return b04b;
-    case 0x04c:
-        return b04c;
-    case 0x04d:
-        return b04d;
-    case 0x04e:
-        return b04e;
-    case 0x04f:
-        return b04f;
-    case 0x050:
-        return b050;
-    case 0x051:
-        return b051;
-    case 0x052:
-        return b052;
-    case 0x053:
-        return b053;
-    case 0x054:
-        return b054;
-    case 0x055:
-        return b055;
-    case 0x056:
-        return b056;
-    case 0x057:
-        return b057;
-    case 0x058:
-        return b058;
-    case 0x059:
-        return b059;
-    case 0x05a:
-        return b05a;
-    case 0x05b:
-        return b05b;
-    case 0x05c:
-        return b05c;
-    case 0x05d:
-        return b05d;
-    case 0x05e:
-        return b05e;
-    case 0x05f:
-        return b05f;
-    case 0x060:
-        return b060;
-    case 0x061:
-        return b061;
-    case 0x062:
-        return b062;
-    case 0x063:
-        return b063;
-    case 0x064:
-        return b064;
-    case 0x065:
-        return b065;
-    case 0x066:
-        return b066;
-    case 0x067:
-        return b067;
-    case 0x068:
-        return b068;
-    case 0x069:
-        return b069;
-    case 0x06a:
-        return b06a;
-    case 0x06b:
-        return b06b;
-    case 0x06c:
-        return b06c;
-    case 0x06d:
-        return b06d;
-    case 0x06e:
-        return b06e;
-    case 0x06f:
-        return b06f;
-    case 0x070:
-        return b070;
-    case 0x071:
-        return b071;
-    case 0x072:
-        return b072;
-    case 0x073:
-        return b073;
-    case 0x074:
-        return b074;
-    case 0x075:
-        return b075;
-    case 0x076:
-        return b076;
-    case 0x077:
-        return b077;
-    case 0x078:
-        return b078;
-    case 0x079:
-        return b079;
-    case 0x07a:
-        return b07a;
-    case 0x07b:
-        return b07b;
-    case 0x07c:
-        return b07c;
-    case 0x07d:
-        return b07d;
-    case 0x07e:
-        return b07e;
-    case 0x07f:
-        return b07f;
-    case 0x080:
-        return b080;
-    case 0x081:
-        return b081;
-    case 0x082:
-        return b082;
-    case 0x083:
-        return b083;
-    case 0x084:
-        return b084;
-    case 0x085:
-        return b085;
-    case 0x086:
-        return b086;
-    case 0x087:
-        return b087;
-    case 0x088:
-        return b088;
-    case 0x089:
-        return b089;
-    case 0x08a:
-        return b08a;
-    case 0x08b:
-        return b08b;
-    case 0x08c:
-        return b08c;
-    case 0x08d:
-        return b08d;
-    case 0x08e:
-        return b08e;
-    case 0x08f:
-        return b08f;
-    case 0x090:
-        return b090;
-    case 0x091:
-        return b091;
-    case 0x092:
-        return b092;
-    case 0x093:
-        return b093;
-    case 0x094:
-        return b094;
-    case 0x095:
-        return b095;
-    case 0x096:
-        return b096;
-    case 0x097:
-        return b097;
-    case 0x098:
-        return b098;
-    case 0x099:
-        return b099;
-    case 0x09a:
-        return b09a;
-    case 0x09b:
-        return b09b;
-    case 0x09c:
-        return b09c;
-    case 0x09d:
-        return b09d;
-    case 0x09e:
-        return b09e;
-    case 0x09f:
-        return b09f;
-    case 0x0a0:
-        return b0a0;
-    case 0x0a1:
-        return b0a1;
-    case 0x0a2:
-        return b0a2;
-    case 0x0a3:
-        return b0a3;
-    case 0x0a4:
-        return b0a4;
-    case 0x0a5:
-        return b0a5;
-    case 0x0a6:
-        return b0a6;
-    case 0x0a7:
-        return b0a7;
-    case 0x0a8:
-        return b0a8;
-    case 0x0a9:
-        return b0a9;
-    case 0x0aa:
-        return b0aa;
-    case 0x0ab:
-        return b0ab;
-    case 0x0ac:
-        return b0ac;
-    case 0x0ad:
-        return b0ad;
-    case 0x0ae:
-        return b0ae;
-    case 0x0af:
-        return b0af;
-    case 0x0b0:
-        return b0b0;
-    case 0x0b1:
-        return b0b1;
-    case 0x0b2:
-        return b0b2;
-    case 0x0b3:
-        return b0b3;
-    case 0x0b4:
-        return b0b4;
-    case 0x0b5:
-        return b0b5;
-    case 0x0b6:
-        return b0b6;
-    case 0x0b7:
-        return b0b7;
-    case 0x0b8:
-        return b0b8;
-    case 0x0b9:
-        return b0b9;
-    case 0x0ba:
-        return b0ba;
-    case 0x0bb:
-        return b0bb;
-    case 0x0bc:
-        return b0bc;
-    case 0x0bd:
-        return b0bd;
-    case 0x0be:
-        return b0be;
-    case 0x0bf:
-        return b0bf;
-    case 0x0c0:
-        return b0c0;
-    case 0x0c1:
-        return b0c1;
-    case 0x0c2:
-        return b0c2;
-    case 0x0c3:
-        return b0c3;
-    case 0x0c4:
-        return b0c4;
-    case 0x0c5:
-        return b0c5;
-    case 0x0c6:
-        return b0c6;
-    case 0x0c7:
-        return b0c7;
-    case 0x0c8:
-        return b0c8;
-    case 0x0c9:
-        return b0c9;
-    case 0x0ca:
-        return b0ca;
-    case 0x0cb:
-        return b0cb;
-    case 0x0cc:
-        return b0cc;
-    case 0x0cd:
-        return b0cd;
-    case 0x0ce:
-        return b0ce;
-    case 0x0cf:
-        return b0cf;
-    case 0x0d0:
-        return b0d0;
-    case 0x0d1:
-        return b0d1;
-    case 0x0d2:
-        return b0d2;
-    case 0x0d3:
-        return b0d3;
-    case 0x0d4:
-        return b0d4;
-    case 0x0d5:
-        return b0d5;
-    case 0x0d6:
-        return b0d6;
-    case 0x0d7:
-        return b0d7;
-    case 0x0f9:
-        return b0f9;
-    case 0x0fa:
-        return b0fa;
-    case 0x0fb:
-        return b0fb;
-    case 0x0fc:
-        return b0fc;
-    case 0x0fd:
-        return b0fd;
-    case 0x0fe:
-        return b0fe;
-    case 0x0ff:
-        return b0ff;
-    case 0x100:
-        return b100;
-    case 0x101:
-        return b101;
-    case 0x102:
-        return b102;
-    case 0x103:
-        return b103;
-    case 0x104:
-        return b104;
-    case 0x105:
-        return b105;
-    case 0x106:
-        return b106;
-    case 0x107:
-        return b107;
-    case 0x108:
-        return b108;
-    case 0x109:
-        return b109;
-    case 0x10a:
-        return b10a;
-    case 0x10b:
-        return b10b;
-    case 0x10c:
-        return b10c;
-    case 0x10d:
-        return b10d;
-    case 0x10e:
-        return b10e;
-    case 0x10f:
-        return b10f;
-    case 0x110:
-        return b110;
-    case 0x111:
-        return b111;
-    case 0x112:
-        return b112;
-    case 0x113:
-        return b113;
-    case 0x114:
-        return b114;
-    case 0x115:
-        return b115;
-    case 0x116:
-        return b116;
-    case 0x117:
-        return b117;
-    case 0x118:
-        return b118;
-    case 0x119:
-        return b119;
-    case 0x11a:
-        return b11a;
-    case 0x11b:
-        return b11b;
-    case 0x11c:
-        return b11c;
-    case 0x11d:
-        return b11d;
-    case 0x11e:
-        return b11e;
-    case 0x11f:
-        return b11f;
-    case 0x124:
-        return b124;
-    case 0x12f:
-        return b12f;
-    case 0x130:
-        return b130;
-    case 0x131:
-        return b131;
-    case 0x132:
-        return b132;
-    case 0x133:
-        return b133;
-    case 0x134:
-        return b134;
-    case 0x144:
-        return b144;
-    case 0x145:
-        return b145;
-    case 0x146:
-        return b146;
-    case 0x16a:
-        return b16a;
-    case 0x16b:
-        return b16b;
-    case 0x16e:
-        return b16e;
-    case 0x16f:
-        return b16f;
-    case 0x170:
-        return b170;
-    case 0x171:
-        return b171;
-    case 0x172:
-        return b172;
-    case 0x173:
-        return b173;
-    case 0x174:
-        return b174;
-    case 0x175:
-        return b175;
-    case 0x176:
-        return b176;
-    case 0x177:
-        return b177;
-    case 0x178:
-        return b178;
-    case 0x179:
-        return b179;
-    case 0x17a:
-        return b17a;
-    case 0x17b:
-        return b17b;
-    case 0x17c:
-        return b17c;
-    case 0x17d:
-        return b17d;
-    case 0x17e:
-        return b17e;
-    case 0x17f:
-        return b17f;
-    case 0x180:
-        return b180;
-    case 0x181:
-        return b181;
-    case 0x182:
-        return b182;
-    case 0x183:
-        return b183;
-    case 0x184:
-        return b184;
-    case 0x185:
-        return b185;
-    case 0x186:
-        return b186;
-    case 0x187:
-        return b187;
-    case 0x188:
-        return b188;
-    case 0x189:
-        return b189;
-    case 0x18a:
-        return b18a;
-    case 0x18b:
-        return b18b;
-    case 0x18c:
-        return b18c;
-    case 0x18d:
-        return b18d;
-    case 0x1b0:
-        return b1b0;
-    case 0x1b1:
-        return b1b1;
-    case 0x1b2:
-        return b1b2;
-    case 0x1bc:
-        return b1bc;
-    case 0x1cf:
-        return b1cf;
-    case 0x1d0:
-        return b1d0;
-    case 0x1d1:
-        return b1d1;
-    case 0x1d2:
-        return b1d2;
-    case 0x1d3:
-        return b1d3;
-    case 0x1d4:
-        return b1d4;
-    case 0x1d5:
-        return b1d5;
-    case 0x1d6:
-        return b1d6;
-    case 0x1d7:
-        return b1d7;
-    case 0x1df:
-        return b1df;
-    case 0x1e0:
-        return b1e0;
-    case 0x1e1:
-        return b1e1;
-    case 0x1e2:
-        return b1e2;
-    case 0x1e4:
-        return b1e4;
-    case 0x1e7:
-        return b1e7;
-    case 0x1e8:
-        return b1e8;
-    case 0x1e9:
-        return b1e9;
-    case 0x1ec:
-        return b1ec;
-    case 0x1ed:
-        return b1ed;
-    case 0x1ee:
-        return b1ee;
-    case 0x1f0:
-        return b1f0;
-    case 0x1f1:
-        return b1f1;
-    case 0x1f2:
-        return b1f2;
-    case 0x1f3:
-        return b1f3;
-    case 0x1f4:
-        return b1f4;
-    case 0x1f5:
-        return b1f5;
-    case 0x1f6:
-        return b1f6;
-    case 0x1f7:
-        return b1f7;
-    case 0x1f8:
-        return b1f8;
-    case 0x1f9:
-        return b1f9;
-    case 0x1fa:
-        return b1fa;
-    case 0x1fb:
-        return b1fb;
-    case 0x200:
-        return b200;
-    case 0x201:
-        return b201;
-    case 0x202:
-        return b202;
-    case 0x203:
-        return b203;
-    case 0x204:
-        return b204;
-    case 0x205:
-        return b205;
-    case 0x206:
-        return b206;
-    case 0x207:
-        return b207;
-    case 0x208:
-        return b208;
-    case 0x209:
-        return b209;
-    case 0x20a:
-        return b20a;
-    case 0x20b:
-        return b20b;
-    case 0x20c:
-        return b20c;
-    case 0x20d:
-        return b20d;
-    case 0x20e:
-        return b20e;
-    case 0x20f:
-        return b20f;
-    case 0x210:
-        return b210;
-    case 0x211:
-        return b211;
-    case 0x212:
-        return b212;
-    case 0x213:
-        return b213;
-    case 0x214:
-        return b214;
-    case 0x215:
-        return b215;
-    case 0x216:
-        return b216;
-    case 0x217:
-        return b217;
-    case 0x218:
-        return b218;
-    case 0x219:
-        return b219;
-    case 0x21a:
-        return b21a;
-    case 0x21b:
-        return b21b;
-    case 0x21c:
-        return b21c;
-    case 0x21d:
-        return b21d;
-    case 0x21e:
-        return b21e;
-    case 0x21f:
-        return b21f;
-    case 0x220:
-        return b220;
-    case 0x221:
-        return b221;
-    case 0x222:
-        return b222;
-    case 0x223:
-        return b223;
-    case 0x224:
-        return b224;
-    case 0x225:
-        return b225;
-    case 0x226:
-        return b226;
-    case 0x227:
-        return b227;
-    case 0x228:
-        return b228;
-    case 0x229:
-        return b229;
-    case 0x22a:
-        return b22a;
-    case 0x22b:
-        return b22b;
-    case 0x22c:
-        return b22c;
-    case 0x22d:
-        return b22d;
-    case 0x22e:
-        return b22e;
-    case 0x22f:
-        return b22f;
-    case 0x230:
-        return b230;
-    case 0x231:
-        return b231;
-    case 0x232:
-        return b232;
-    case 0x233:
-        return b233;
-    case 0x234:
-        return b234;
-    case 0x235:
-        return b235;
-    case 0x236:
-        return b236;
-    case 0x237:
-        return b237;
-    case 0x238:
-        return b238;
-    case 0x239:
-        return b239;
-    case 0x23a:
-        return b23a;
-    case 0x23b:
-        return b23b;
-    case 0x23c:
-        return b23c;
-    case 0x23d:
-        return b23d;
-    case 0x23e:
-        return b23e;
-    case 0x23f:
-        return b23f;
-    case 0x240:
-        return b240;
-    case 0x241:
-        return b241;
-    case 0x242:
-        return b242;
-    case 0x243:
-        return b243;
-    case 0x244:
-        return b244;
-    case 0x245:
-        return b245;
-    case 0x246:
-        return b246;
-    case 0x247:
-        return b247;
-    case 0x248:
-        return b248;
-    case 0x249:
-        return b249;
-    case 0x24a:
-        return b24a;
-    case 0x24b:
-        return b24b;
-    case 0x24c:
-        return b24c;
-    case 0x24d:
-        return b24d;
-    case 0x24e:
-        return b24e;
-    case 0x24f:
-        return b24f;
-    case 0x250:
-        return b250;
-    case 0x251:
-        return b251;
-    case 0x252:
-        return b252;
-    case 0x253:
-        return b253;
-    case 0x254:
-        return b254;
-    case 0x255:
-        return b255;
-    case 0x256:
-        return b256;
-    case 0x257:
-        return b257;
-    case 0x258:
-        return b258;
-    case 0x259:
-        return b259;
-    case 0x25a:
-        return b25a;
-    case 0x25b:
-        return b25b;
-    case 0x25c:
-        return b25c;
-    case 0x25d:
-        return b25d;
-    case 0x25e:
-        return b25e;
-    case 0x25f:
-        return b25f;
-    case 0x260:
-        return b260;
-    case 0x261:
-        return b261;
-    case 0x262:
-        return b262;
-    case 0x263:
-        return b263;
-    case 0x264:
-        return b264;
-    case 0x265:
-        return b265;
-    case 0x266:
-        return b266;
-    case 0x267:
-        return b267;
-    case 0x268:
-        return b268;
-    case 0x269:
-        return b269;
-    case 0x26a:
-        return b26a;
-    case 0x26b:
-        return b26b;
-    case 0x26c:
-        return b26c;
-    case 0x26d:
-        return b26d;
-    case 0x26e:
-        return b26e;
-    case 0x26f:
-        return b26f;
-    case 0x270:
-        return b270;
-    case 0x271:
-        return b271;
-    case 0x272:
-        return b272;
-    case 0x273:
-        return b273;
-    case 0x274:
-        return b274;
-    case 0x275:
-        return b275;
-    case 0x276:
-        return b276;
-    case 0x277:
-        return b277;
-    case 0x278:
-        return b278;
-    case 0x279:
-        return b279;
-    case 0x27a:
-        return b27a;
-    case 0x27b:
-        return b27b;
-    case 0x27c:
-        return b27c;
-    case 0x27d:
-        return b27d;
-    case 0x27e:
-        return b27e;
-    case 0x27f:
-        return b27f;
-    case 0x280:
-        return b280;
-    case 0x281:
-        return b281;
-    case 0x282:
-        return b282;
-    case 0x283:
-        return b283;
-    case 0x284:
-        return b284;
-    case 0x285:
-        return b285;
-    case 0x286:
-        return b286;
-    case 0x287:
-        return b287;
-    case 0x288:
-        return b288;
-    case 0x289:
-        return b289;
-    case 0x28a:
-        return b28a;
-    case 0x28b:
-        return b28b;
-    case 0x28c:
-        return b28c;
-    case 0x28d:
-        return b28d;
-    case 0x28e:
-        return b28e;
-    case 0x28f:
-        return b28f;
-    case 0x290:
-        return b290;
-    case 0x291:
-        return b291;
-    case 0x292:
-        return b292;
-    case 0x293:
-        return b293;
-    case 0x294:
-        return b294;
-    case 0x295:
-        return b295;
-    case 0x296:
-        return b296;
-    case 0x297:
-        return b297;
-    case 0x298:
-        return b298;
-    case 0x299:
-        return b299;
-    case 0x29a:
-        return b29a;
-    case 0x29b:
-        return b29b;
-    case 0x29c:
-        return b29c;
-    case 0x29d:
-        return b29d;
-    case 0x29e:
-        return b29e;
-    case 0x29f:
-        return b29f;
-    case 0x2a0:
-        return b2a0;
-    case 0x2a1:
-        return b2a1;
-    case 0x2a2:
-        return b2a2;
-    case 0x2a3:
-        return b2a3;
-    case 0x2a4:
-        return b2a4;
-    case 0x2a5:
-        return b2a5;
-    case 0x2a6:
-        return b2a6;
-    case 0x2a7:
-        return b2a7;
-    case 0x2a8:
-        return b2a8;
-    case 0x2a9:
-        return b2a9;
-    case 0x2aa:
-        return b2aa;
-    case 0x2ab:
-        return b2ab;
-    case 0x2ac:
-        return b2ac;
-    case 0x2ad:
-        return b2ad;
-    case 0x2ae:
-        return b2ae;
-    case 0x2af:
-        return b2af;
-    case 0x2b0:
-        return b2b0;
-    case 0x2b1:
-        return b2b1;
-    case 0x2b2:
-        return b2b2;
-    case 0x2b3:
-        return b2b3;
-    case 0x2b4:
-        return b2b4;
-    case 0x2b5:
-        return b2b5;
-    case 0x2b6:
-        return b2b6;
-    case 0x2b7:
-        return b2b7;
-    case 0x2b8:
-        return b2b8;
-    case 0x2b9:
-        return b2b9;
-    case 0x2ba:
-        return b2ba;
-    case 0x2bb:
-        return b2bb;
-    case 0x2bc:
-        return b2bc;
-    case 0x2bd:
-        return b2bd;
-    case 0x2be:
-        return b2be;
-    case 0x2bf:
-        return b2bf;
-    case 0x2c0:
-        return b2c0;
-    case 0x2c1:
-        return b2c1;
-    case 0x2c2:
-        return b2c2;
-    case 0x2c3:
-        return b2c3;
-    case 0x2c4:
-        return b2c4;
-    case 0x2c5:
-        return b2c5;
-    case 0x2c6:
-        return b2c6;
-    case 0x2c7:
-        return b2c7;
-    case 0x2c8:
-        return b2c8;
-    case 0x2c9:
-        return b2c9;
-    case 0x2ca:
-        return b2ca;
-    case 0x2cb:
-        return b2cb;
-    case 0x2cc:
-        return b2cc;
-    case 0x2cd:
-        return b2cd;
-    case 0x2ce:
-        return b2ce;
-    case 0x2cf:
-        return b2cf;
-    case 0x2d0:
-        return b2d0;
-    case 0x2d1:
-        return b2d1;
-    case 0x2d2:
-        return b2d2;
-    case 0x2d3:
-        return b2d3;
-    case 0x2d5:
-        return b2d5;
-    case 0x2d6:
-        return b2d6;
-    case 0x2d7:
-        return b2d7;
-    case 0x2d8:
-        return b2d8;
-    case 0x2d9:
-        return b2d9;
-    case 0x2da:
-        return b2da;
-    case 0x2db:
-        return b2db;
-    case 0x2dc:
-        return b2dc;
-    case 0x2dd:
-        return b2dd;
-    case 0x2de:
-        return b2de;
-    case 0x2e0:
-        return b2e0;
-    case 0x2e1:
-        return b2e1;
-    case 0x2e2:
-        return b2e2;
-    case 0x2e3:
-        return b2e3;
-    case 0x2e4:
-        return b2e4;
-    case 0x2e5:
-        return b2e5;
-    case 0x2e6:
-        return b2e6;
-    case 0x2e7:
-        return b2e7;
-    case 0x2e8:
-        return b2e8;
-    case 0x2e9:
-        return b2e9;
-    case 0x2ea:
-        return b2ea;
-    case 0x2eb:
-        return b2eb;
-    case 0x2f8:
-        return b2f8;
-    case 0x2f9:
-        return b2f9;
-    case 0x2fa:
-        return b2fa;
-    case 0x300:
-        return b300;
-    case 0x301:
-        return b301;
-    case 0x302:
-        return b302;
-    case 0x303:
-        return b303;
-    case 0x304:
-        return b304;
-    case 0x305:
-        return b305;
-    case 0x306:
-        return b306;
-    case 0x307:
-        return b307;
-    case 0x308:
-        return b308;
-    case 0x309:
-        return b309;
-    case 0x30a:
-        return b30a;
-    case 0x30b:
-        return b30b;
-    case 0x30c:
-        return b30c;
-    case 0x30d:
-        return b30d;
-    case 0x30e:
-        return b30e;
-    case 0x30f:
-        return b30f;
-    case 0x310:
-        return b310;
-    case 0x311:
-        return b311;
-    case 0x312:
-        return b312;
-    case 0x313:
-        return b313;
-    case 0x314:
-        return b314;
-    case 0x315:
-        return b315;
-    case 0x316:
-        return b316;
-    case 0x317:
-        return b317;
-    case 0x318:
-        return b318;
-    case 0x319:
-        return b319;
-    case 0x31f:
-        return b31f;
-    case 0x320:
-        return b320;
-    case 0xe00:
+    if (blocknum < sizeof(blocks) / sizeof(blocks[0]))
+        return blocks[blocknum];
+    if (blocknum == 0xe00)
         return be00;
-    default:
-        return bdefault;
-    }
+    return bdefault;
 }
 
 size_t anyascii(uint_least32_t utf32, const char **ascii)
@@ -0,0 +1,225 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include "componenttree.h"
+#include "helpers.h"
+
+namespace AsciiRename
+{
+
+static constexpr size_t InitialSlots = 1024;
+
+// Garbage below this is never worth compacting away
+static constexpr size_t MinCompactBytes = 64 * 1024;
+
+ComponentTree::ComponentTree()
+    : parents_{Root}, depths_{0}, childCounts_{0}, nameOffsets_{0}, nameLengths_{0}, currentOffsets_{0},
+      currentLengths_{0}, slots_(InitialSlots, Root)
+{
+}
+
+// The slot a child with this parent and name hashes to
+size_t ComponentTree::Home(NodeId parent, StringView name) const
+{
+    // FNV-1a over the name, seeded with the parent
+    uint64_t hash = 0xcbf29ce484222325ull ^ (parent * 0x9E3779B97F4A7C15ull);
+    for (auto c : name)
+    {
+        hash = (hash ^ static_cast<uint64_t>(c)) * 0x100000001b3ull;
+    }
+    return static_cast<size_t>(hash) & (slots_.size() - 1);
+}
+
+// Finds the slot holding parent's child with this name, or the empty slot where it
+// belongs
+size_t ComponentTree::Slot(NodeId parent, StringView name) const
+{
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = Home(parent, name);; slot = (slot + 1) & mask)
+    {
+        NodeId node = slots_[slot];
+        if (node == Root || (parents_[node] == parent && OriginalName(node) == name))
+        {
+            return slot;
+        }
+    }
+}
+
+// Doubles the index, keeping it at most half full
+void ComponentTree::Grow()
+{
+    slots_.assign(slots_.size() * 2, Root);
+    for (NodeId node = 1; node < parents_.size(); ++node)
+    {
+        if (parents_[node] != Released)
+        {
+            slots_[Slot(parents_[node], OriginalName(node))] = node;
+        }
+    }
+}
+
+// Empties a slot, shifting later nodes of the same probe run back so every node stays
+// reachable from its home slot
+void ComponentTree::Erase(size_t slot)
+{
+    size_t mask = slots_.size() - 1;
+    size_t hole = slot;
+    slots_[hole] = Root;
+    for (size_t next = (hole + 1) & mask; slots_[next] != Root; next = (next + 1) & mask)
+    {
+        NodeId node = slots_[next];
+        size_t home = Home(parents_[node], OriginalName(node));
+
+        // The node can fill the hole if its home isn't cyclically in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            slots_[hole] = node;
+            slots_[next] = Root;
+            hole = next;
+        }
+    }
+}
+
+// Rewrites the arena with only the names live nodes refer to
+void ComponentTree::Compact()
+{
+    String arena;
+    arena.reserve(arena_.size() - garbage_);
+    for (NodeId node = 1; node < parents_.size(); ++node)
+    {
+        if (parents_[node] == Released)
+        {
+            continue;
+        }
+
+        bool renamed = currentOffsets_[node] != nameOffsets_[node];
+        auto original = OriginalName(node);
+        auto current = Name(node);
+        nameOffsets_[node] = arena.size();
+        arena.append(original);
+        if (renamed)
+        {
+            currentOffsets_[node] = arena.size();
+            arena.append(current);
+        }
+        else
+        {
+            currentOffsets_[node] = nameOffsets_[node];
+        }
+    }
+    arena_ = std::move(arena);
+    garbage_ = 0;
+}
+
+ComponentTree::NodeId ComponentTree::Intern(NodeId parent, StringView name, bool renameable)
+{
+    size_t slot = Slot(parent, name);
+    if (slots_[slot] != Root)
+    {
+        return slots_[slot];
+    }
+
+    NodeId node;
+    if (free_.empty())
+    {
+        node = static_cast<NodeId>(parents_.size());
+        parents_.emplace_back();
+        depths_.emplace_back();
+        childCounts_.emplace_back();
+        nameOffsets_.emplace_back();
+        nameLengths_.emplace_back();
+        currentOffsets_.emplace_back();
+        currentLengths_.emplace_back();
+    }
+    else
+    {
+        node = free_.back();
+        free_.pop_back();
+    }
+
+    parents_[node] = parent;
+    depths_[node] = depths_[parent] + (renameable ? 1 : 0);
+    childCounts_[node] = 0;
+    ++childCounts_[parent];
+    nameOffsets_[node] = arena_.size();
+    nameLengths_[node] = static_cast<uint32_t>(name.size());
+    currentOffsets_[node] = arena_.size();
+    currentLengths_[node] = static_cast<uint32_t>(name.size());
+    arena_.append(name);
+
+    slots_[slot] = node;
+    if ((parents_.size() - free_.size()) * 2 > slots_.size())
+    {
+        Grow();
+    }
+    return node;
+}
+
+ComponentTree::NodeId ComponentTree::Find(NodeId parent, StringView name) const
+{
+    return slots_[Slot(parent, name)];
+}
+
+bool ComponentTree::Release(NodeId node)
+{
+    if (node == Root || childCounts_[node] != 0)
+    {
+        return false;
+    }
+
+    Erase(Slot(parents_[node], OriginalName(node)));
+    --childCounts_[parents_[node]];
+
+    garbage_ += nameLengths_[node];
+    if (currentOffsets_[node] != nameOffsets_[node])
+    {
+        garbage_ += currentLengths_[node];
+    }
+    parents_[node] = Released;
+    free_.push_back(node);
+
+    if (garbage_ > MinCompactBytes && garbage_ * 2 > arena_.size())
+    {
+        Compact();
+    }
+    return true;
+}
+
+ComponentTree::NodeId ComponentTree::Intern(std::filesystem::path const &path)
+{
+    NodeId node = Root;
+    for (auto const &component : path)
+    {
+        node = Intern(node, component.native(), IsRenameableComponent(component));
+    }
+    return node;
+}
+
+std::filesystem::path ComponentTree::Path(NodeId node) const
+{
+    std::vector<NodeId> chain;
+    for (; node != Root; node = parents_[node])
+    {
+        chain.push_back(node);
+    }
+
+    std::filesystem::path result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        result /= Name(*it);
+    }
+    return result;
+}
+
+void ComponentTree::Rename(NodeId node, StringView newName)
+{
+    if (currentOffsets_[node] != nameOffsets_[node])
+    {
+        garbage_ += currentLengths_[node];
+    }
+    currentOffsets_[node] = arena_.size();
+    currentLengths_[node] = static_cast<uint32_t>(newName.size());
+    arena_.append(newName);
+}
+
+} // namespace AsciiRename
@@ -0,0 +1,122 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef COMPONENTTREE_H
+#define COMPONENTTREE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace AsciiRename
+{
+
+// Every path the run touches, interned as a tree of components. Each node is stored
+// as its parent's index and its name's place in one shared arena, in parallel arrays,
+// so a path is a small integer and shared prefixes are stored once. Renames are
+// applied to the nodes themselves, so a node's path always reflects renamed ancestors.
+// Leaves that are no longer needed can be released, so their ids and name storage are
+// reused and a tree that is pruned as it goes stays small.
+class ComponentTree
+{
+public:
+    using NodeId = uint32_t;
+    using String = std::filesystem::path::string_type;
+    using StringView = std::basic_string_view<std::filesystem::path::value_type>;
+
+    // The empty path that top-level components hang from
+    static constexpr NodeId Root = 0;
+
+private:
+    // Marks a released node in parents_
+    static constexpr NodeId Released = UINT32_MAX;
+
+    std::vector<NodeId> parents_;
+    std::vector<uint32_t> depths_;
+    std::vector<uint32_t> childCounts_;
+    std::vector<size_t> nameOffsets_;
+    std::vector<uint32_t> nameLengths_;
+
+    // The name after any rename; the same as the original name otherwise
+    std::vector<size_t> currentOffsets_;
+    std::vector<uint32_t> currentLengths_;
+
+    String arena_;
+    // Arena bytes no live node refers to any more
+    size_t garbage_ = 0;
+
+    // Released ids, reused before new ones
+    std::vector<NodeId> free_;
+
+    // Open-addressed index of children by parent and original name. Root is never
+    // a child, so 0 marks an empty slot.
+    std::vector<NodeId> slots_;
+
+    StringView OriginalName(NodeId node) const
+    {
+        return StringView(arena_).substr(nameOffsets_[node], nameLengths_[node]);
+    }
+
+    size_t Home(NodeId parent, StringView name) const;
+    size_t Slot(NodeId parent, StringView name) const;
+    void Grow();
+    void Erase(size_t slot);
+    void Compact();
+
+public:
+    ComponentTree();
+
+    // One past the largest id in use, for sizing tables indexed by node
+    size_t Size() const
+    {
+        return parents_.size();
+    }
+
+    // Returns the child of parent with the given name, adding it if it's new.
+    // Components that can't be renamed (roots, drive letters, . and ..) don't count
+    // toward depth.
+    NodeId Intern(NodeId parent, StringView name, bool renameable = true);
+
+    // Interns every component of path and returns the last
+    NodeId Intern(std::filesystem::path const &path);
+
+    // Returns the child of parent with the given original name, or Root if it isn't
+    // interned
+    NodeId Find(NodeId parent, StringView name) const;
+
+    // Drops a node with no children, so its id can be handed out again by Intern.
+    // Returns false, keeping the node, if it still has children.
+    bool Release(NodeId node);
+
+    NodeId Parent(NodeId node) const
+    {
+        return parents_[node];
+    }
+
+    // Renameable components from the top down to and including this one
+    uint32_t Depth(NodeId node) const
+    {
+        return depths_[node];
+    }
+
+    bool IsRenameable(NodeId node) const
+    {
+        return node != Root && depths_[node] != depths_[parents_[node]];
+    }
+
+    // The node's name, after any rename
+    StringView Name(NodeId node) const
+    {
+        return StringView(arena_).substr(currentOffsets_[node], currentLengths_[node]);
+    }
+
+    // The node's full path, after any renames of it or its ancestors
+    std::filesystem::path Path(NodeId node) const;
+
+    void Rename(NodeId node, StringView newName);
+};
+
+} // namespace AsciiRename
+
+#endif
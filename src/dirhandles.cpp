@@ -0,0 +1,159 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "dirhandles.h"
+
+namespace AsciiRename
+{
+
+DirectoryHandles::DirectoryHandles(size_t limit) : limit_(limit)
+{
+    // Leave most fds to the rest of the process, e.g. the walker's threads
+    struct rlimit fdLimit;
+    if (getrlimit(RLIMIT_NOFILE, &fdLimit) == 0 && fdLimit.rlim_cur != RLIM_INFINITY)
+    {
+        limit_ = std::min<size_t>(limit_, fdLimit.rlim_cur / 4);
+    }
+}
+
+DirectoryHandles::~DirectoryHandles()
+{
+    for (int fd : fds_)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+void DirectoryHandles::Pin(ComponentTree::NodeId node)
+{
+    if (node != ComponentTree::Root && pins_[node]++ == 0)
+    {
+        unpinned_.erase(positions_[node]);
+    }
+}
+
+void DirectoryHandles::Unpin(ComponentTree::NodeId node)
+{
+    if (node != ComponentTree::Root && --pins_[node] == 0)
+    {
+        positions_[node] = unpinned_.insert(unpinned_.end(), node);
+    }
+}
+
+// Opens node's directory through its parent's handle, opening that first if needed
+int DirectoryHandles::Open(ComponentTree const &tree, ComponentTree::NodeId node)
+{
+    if (node == ComponentTree::Root)
+    {
+        return AT_FDCWD;
+    }
+
+    if (node >= fds_.size())
+    {
+        fds_.resize(tree.Size(), -1);
+        parents_.resize(tree.Size(), ComponentTree::Root);
+        pins_.resize(tree.Size(), 0);
+        positions_.resize(tree.Size());
+    }
+    if (fds_[node] != -1)
+    {
+        return fds_[node];
+    }
+
+    auto parent = tree.Parent(node);
+    int parentFd = Open(tree, parent);
+    if (parentFd == -1)
+    {
+        return -1;
+    }
+
+    // Pinned first, so making room can't close it
+    Pin(parent);
+    while (open_ >= limit_ && EvictOne())
+    {
+    }
+
+    // O_PATH only pins the directory; nothing is read through it
+    std::string name(tree.Name(node));
+    int fd;
+    while ((fd = openat(parentFd, name.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC)) == -1 &&
+           (errno == EMFILE || errno == ENFILE) && EvictOne())
+    {
+        // Out of fds; retry once another handle is closed
+    }
+
+    if (fd == -1)
+    {
+        int error = errno;
+        Unpin(parent);
+        errno = error;
+        return -1;
+    }
+
+    fds_[node] = fd;
+    parents_[node] = parent;
+    positions_[node] = unpinned_.insert(unpinned_.end(), node);
+    ++open_;
+    return fd;
+}
+
+// Closes an open, unpinned handle, which may leave its parent unpinned in turn
+void DirectoryHandles::Close(ComponentTree::NodeId node)
+{
+    close(fds_[node]);
+    fds_[node] = -1;
+    unpinned_.erase(positions_[node]);
+    --open_;
+    Unpin(parents_[node]);
+}
+
+// Closes the least recently released handle nothing pins. Returns false if there's none.
+bool DirectoryHandles::EvictOne()
+{
+    if (unpinned_.empty())
+    {
+        return false;
+    }
+
+    Close(unpinned_.front());
+    return true;
+}
+
+int DirectoryHandles::Acquire(ComponentTree const &tree, ComponentTree::NodeId node)
+{
+    int fd = Open(tree, node);
+    if (fd != -1)
+    {
+        Pin(node);
+    }
+    return fd;
+}
+
+void DirectoryHandles::Release(ComponentTree::NodeId node)
+{
+    Unpin(node);
+}
+
+void DirectoryHandles::Forget(ComponentTree::NodeId node)
+{
+    // A pinned handle has an op or an open child below it, so the node isn't released
+    if (node >= fds_.size() || fds_[node] == -1 || pins_[node] != 0)
+    {
+        return;
+    }
+
+    Close(node);
+}
+
+} // namespace AsciiRename
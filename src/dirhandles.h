@@ -0,0 +1,67 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef DIRHANDLES_H
+#define DIRHANDLES_H
+
+#include <cstdint>
+#include <list>
+#include <vector>
+
+#include "componenttree.h"
+
+namespace AsciiRename
+{
+
+// Open directory fds for nodes of a ComponentTree, each opened relative to its
+// parent's. An fd follows its directory through renames, so renaming an ancestor
+// never invalidates a handle below it and an op can address its entry by parent fd
+// and name alone, without the kernel resolving the full path again.
+//
+// Not thread-safe; callers serialize access. An open handle pins its parent's, so a
+// directory stays open while anything below it is, and reopening an evicted handle
+// only has to open that one level. Once the limit (capped at a quarter of the fd
+// limit) is reached, or the process runs out of fds, the least recently released
+// handle that nothing pins is closed, one at a time.
+class DirectoryHandles
+{
+    std::vector<int> fds_;
+    std::vector<ComponentTree::NodeId> parents_;
+
+    // Acquire calls not yet released, plus open handles of child directories
+    std::vector<uint32_t> pins_;
+
+    // Open handles with no pins, least recently released first
+    std::list<ComponentTree::NodeId> unpinned_;
+    std::vector<std::list<ComponentTree::NodeId>::iterator> positions_;
+
+    size_t open_ = 0;
+    size_t limit_;
+
+    int Open(ComponentTree const &tree, ComponentTree::NodeId node);
+    void Close(ComponentTree::NodeId node);
+    bool EvictOne();
+    void Pin(ComponentTree::NodeId node);
+    void Unpin(ComponentTree::NodeId node);
+
+public:
+    explicit DirectoryHandles(size_t limit);
+    ~DirectoryHandles();
+
+    DirectoryHandles(const DirectoryHandles &) = delete;
+    DirectoryHandles &operator=(const DirectoryHandles &) = delete;
+
+    // Returns an fd for the directory at node, pinned open until Release, or -1 if it
+    // can't be opened. The root gives AT_FDCWD.
+    int Acquire(ComponentTree const &tree, ComponentTree::NodeId node);
+
+    // Unpins a handle returned by Acquire
+    void Release(ComponentTree::NodeId node);
+
+    // Closes the node's handle, if open and unpinned, before the tree releases the node
+    void Forget(ComponentTree::NodeId node);
+};
+
+} // namespace AsciiRename
+
+#endif
@@ -0,0 +1,264 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include "filter.h"
+
+namespace AsciiRename
+{
+
+// Length of the UTF-8 sequence starting at offset, clamped to the end of the name
+static size_t CharLength(std::string_view name, size_t offset)
+{
+    size_t length = 1;
+    while (offset + length < name.size() && (static_cast<unsigned char>(name[offset + length]) & 0xC0) == 0x80)
+    {
+        ++length;
+    }
+    return length;
+}
+
+// Code point of the UTF-8 sequence of the given length at offset, or Invalid if it's
+// malformed, so that a stray byte never matches a class member
+static constexpr char32_t Invalid = 0xFFFFFFFF;
+
+static char32_t DecodeChar(std::string_view name, size_t offset, size_t length)
+{
+    auto lead = static_cast<unsigned char>(name[offset]);
+    if (lead < 0x80)
+    {
+        return lead;
+    }
+
+    size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length != expected)
+    {
+        return Invalid;
+    }
+
+    char32_t c = lead & (0x7F >> length);
+    for (size_t i = 1; i < length; ++i)
+    {
+        c = (c << 6) | (static_cast<unsigned char>(name[offset + i]) & 0x3F);
+    }
+    return c;
+}
+
+Glob::Glob(std::string_view pattern)
+{
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        char c = pattern[i];
+        if (c == '*')
+        {
+            // Runs of stars match the same as one
+            if (tokens_.empty() || tokens_.back().Kind != TokenKind::Star)
+            {
+                tokens_.push_back({TokenKind::Star, {}, {}, {}, false});
+            }
+            continue;
+        }
+
+        if (c == '?')
+        {
+            tokens_.push_back({TokenKind::AnyChar, {}, {}, {}, false});
+            continue;
+        }
+
+        if (c == '[')
+        {
+            // Find the closing bracket; a ] first in the class is a member
+            size_t j = i + 1;
+            bool negate = j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^');
+            if (negate)
+            {
+                ++j;
+            }
+            size_t first = j;
+            if (j < pattern.size() && pattern[j] == ']')
+            {
+                ++j;
+            }
+            while (j < pattern.size() && pattern[j] != ']')
+            {
+                ++j;
+            }
+
+            if (j < pattern.size())
+            {
+                Token token{TokenKind::Class, {}, {}, {}, negate};
+                for (size_t k = first; k < j;)
+                {
+                    size_t length = CharLength(pattern, k);
+                    char32_t low = DecodeChar(pattern, k, length);
+                    char32_t high = low;
+                    k += length;
+                    if (k + 1 < j && pattern[k] == '-')
+                    {
+                        length = CharLength(pattern, k + 1);
+                        high = DecodeChar(pattern, k + 1, length);
+                        k += 1 + length;
+                    }
+                    if (low == Invalid || high == Invalid)
+                    {
+                        continue;
+                    }
+
+                    for (char32_t c = low; c <= high && c < 0x80; ++c)
+                    {
+                        token.Set.set(c);
+                    }
+                    if (high >= 0x80)
+                    {
+                        token.Ranges.emplace_back(std::max<char32_t>(low, 0x80), high);
+                    }
+                }
+                tokens_.push_back(std::move(token));
+                i = j;
+                continue;
+            }
+            // An unclosed [ is a literal
+        }
+
+        if (c == '\\' && i + 1 < pattern.size())
+        {
+            c = pattern[++i];
+        }
+
+        if (tokens_.empty() || tokens_.back().Kind != TokenKind::Literal)
+        {
+            tokens_.push_back({TokenKind::Literal, {}, {}, {}, false});
+        }
+        tokens_.back().Text.push_back(c);
+    }
+}
+
+// Whether a class token matches the code point c
+bool Glob::InClass(Token const &token, char32_t c)
+{
+    bool member = c < 0x80 && token.Set.test(c);
+    for (size_t i = 0; !member && i < token.Ranges.size(); ++i)
+    {
+        member = c >= token.Ranges[i].first && c <= token.Ranges[i].second;
+    }
+    return member != token.Negate;
+}
+
+// Returns how much of the name the token matches at offset, or 0 if it doesn't
+size_t Glob::MatchToken(Token const &token, std::string_view name, size_t offset)
+{
+    switch (token.Kind)
+    {
+    case TokenKind::Literal:
+        return name.compare(offset, token.Text.size(), token.Text) == 0 ? token.Text.size() : 0;
+    case TokenKind::AnyChar:
+        return CharLength(name, offset);
+    case TokenKind::Class:
+        return InClass(token, DecodeChar(name, offset, CharLength(name, offset))) ? CharLength(name, offset) : 0;
+    default:
+        return 0;
+    }
+}
+
+// Greedy match that backtracks only to the most recent star, which is enough since
+// a later star can absorb anything an earlier one would have
+bool Glob::Matches(std::string_view name) const
+{
+    static constexpr size_t NoStar = static_cast<size_t>(-1);
+
+    size_t t = 0;
+    size_t n = 0;
+    size_t starToken = NoStar;
+    size_t starOffset = 0;
+
+    while (n < name.size())
+    {
+        if (t < tokens_.size() && tokens_[t].Kind == TokenKind::Star)
+        {
+            starToken = ++t;
+            starOffset = n;
+            continue;
+        }
+
+        size_t length = t < tokens_.size() ? MatchToken(tokens_[t], name, n) : 0;
+        if (length != 0)
+        {
+            ++t;
+            n += length;
+        }
+        else if (starToken == tokens_.size())
+        {
+            // A trailing star takes the rest of the name
+            return true;
+        }
+        else if (starToken != NoStar)
+        {
+            // Let the last star take one more character and retry from there
+            starOffset += CharLength(name, starOffset);
+            n = starOffset;
+            t = starToken;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (t < tokens_.size() && tokens_[t].Kind == TokenKind::Star)
+    {
+        ++t;
+    }
+    return t == tokens_.size();
+}
+
+// Whether a pattern has no glob syntax at all
+static bool IsPlain(std::string_view pattern)
+{
+    return pattern.find_first_of("*?[\\") == std::string_view::npos;
+}
+
+void GlobSet::Add(std::string_view pattern)
+{
+    if (IsPlain(pattern))
+    {
+        names_.emplace(pattern);
+    }
+    else if (pattern.size() > 2 && pattern[0] == '*' && pattern[1] == '.' && IsPlain(pattern.substr(2)) &&
+             pattern.find('.', 2) == std::string_view::npos)
+    {
+        extensions_.emplace(pattern.substr(2));
+    }
+    else
+    {
+        globs_.emplace_back(pattern);
+    }
+}
+
+bool GlobSet::Matches(std::string_view name) const
+{
+    if (!names_.empty() && names_.count(std::string(name)) != 0)
+    {
+        return true;
+    }
+
+    if (!extensions_.empty())
+    {
+        size_t dot = name.rfind('.');
+        if (dot != std::string_view::npos && extensions_.count(std::string(name.substr(dot + 1))) != 0)
+        {
+            return true;
+        }
+    }
+
+    for (auto const &glob : globs_)
+    {
+        if (glob.Matches(name))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace AsciiRename
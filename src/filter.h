@@ -0,0 +1,99 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace AsciiRename
+{
+
+// A glob compiled to a token list. Supports *, ? (one UTF-8 character), [...] and
+// [!...] classes of UTF-8 characters, and \ to escape the next character.
+class Glob
+{
+    enum class TokenKind
+    {
+        Literal,
+        AnyChar,
+        Star,
+        Class,
+    };
+
+    struct Token
+    {
+        TokenKind Kind;
+        std::string Text;
+
+        // A class's ASCII members, and its non-ASCII members as code point ranges
+        std::bitset<128> Set;
+        std::vector<std::pair<char32_t, char32_t>> Ranges;
+        bool Negate;
+    };
+
+    std::vector<Token> tokens_;
+
+    static bool InClass(Token const &token, char32_t c);
+    static size_t MatchToken(Token const &token, std::string_view name, size_t offset);
+
+public:
+    explicit Glob(std::string_view pattern);
+
+    bool Matches(std::string_view name) const;
+};
+
+// A set of globs matched against entry names. Plain names and "*.ext" patterns, the
+// common cases, are hash lookups; only the rest are matched one by one.
+class GlobSet
+{
+    std::unordered_set<std::string> names_;
+    std::unordered_set<std::string> extensions_;
+    std::vector<Glob> globs_;
+
+public:
+    void Add(std::string_view pattern);
+
+    bool Empty() const
+    {
+        return names_.empty() && extensions_.empty() && globs_.empty();
+    }
+
+    bool Matches(std::string_view name) const;
+};
+
+// Include and exclude patterns applied to each entry during a walk
+struct NameFilter
+{
+    // Only files matching one of these are kept, if there are any
+    GlobSet Include;
+
+    // Entries matching one of these are dropped, directories without being opened
+    GlobSet Exclude;
+
+    bool Empty() const
+    {
+        return Include.Empty() && Exclude.Empty();
+    }
+
+    // Whether an entry is dropped by name alone, before it's typed or opened
+    bool Prunes(std::string_view name) const
+    {
+        return Exclude.Matches(name);
+    }
+
+    // Whether a file that wasn't pruned is left out by the include patterns
+    bool SkipsFile(std::string_view name) const
+    {
+        return !Include.Empty() && !Include.Matches(name);
+    }
+};
+
+} // namespace AsciiRename
+
+#endif
@@ -2,16 +2,28 @@
 // Licensed under the MIT License.
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <stdint.h>
+#include <utility>
 #include <vector>
 
 #include <filesystem>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASCIIRENAME_SSE2
+#endif
+
 #include <anyascii.h>
 #include <libpu8.h>
-#include <utf8.h>
 
 #include "helpers.h"
 
@@ -66,116 +78,601 @@ bool TryGetUtf8(
     }
 }
 
-// Adapted from https://github.com/anyascii/anyascii/blob/0.3.1/impl/c/test.c
-static void anyascii_string(const char *in, char *out)
+static inline unsigned CountTrailingZeros(uint32_t mask)
 {
-    uint32_t utf32;
-    uint32_t state = 0;
-    size_t rlen;
-    for (; *in; in++)
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Returns the length of the run of 7-bit ASCII bytes starting at p
+static size_t AsciiRunLength(const char *p, const char *end)
+{
+    const char *start = p;
+
+#if defined(__AVX2__)
+    for (; end - p >= 32; p += 32)
     {
-        utf8_decode(&state, &utf32, (unsigned char)*in);
-        switch (state)
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+        if (mask != 0)
+        {
+            return static_cast<size_t>(p - start) + CountTrailingZeros(mask);
+        }
+    }
+#endif
+#if defined(__AVX2__) || defined(ASCIIRENAME_SSE2)
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+        if (mask != 0)
+        {
+            return static_cast<size_t>(p - start) + CountTrailingZeros(mask);
+        }
+    }
+#endif
+
+    // Scalar tail (or whole input without SIMD), eight bytes at a time
+    for (; end - p >= 8; p += 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080))
         {
-        case UTF8_ACCEPT:;
-            const char *r;
-            rlen = anyascii(utf32, &r);
-            memcpy(out, r, rlen);
-            out += rlen;
-            break;
-        case UTF8_REJECT:
-            state = UTF8_ACCEPT;
             break;
         }
     }
-    *out = 0;
+
+    while (p < end && !(static_cast<unsigned char>(*p) & 0x80))
+    {
+        ++p;
+    }
+
+    return static_cast<size_t>(p - start);
 }
 
-bool TryGetAscii(std::string const &utf8Input, std::string &output)
+bool IsAscii(std::string_view input)
 {
-    // Allocate buffer with 4x input size to handle worst-case Unicode expansion
-    // (some Unicode characters expand to multiple ASCII characters during transliteration)
-    // +1 for null terminator
-    std::vector<char> buffer(utf8Input.length() * 4 + 1);
-    try
+    return AsciiRunLength(input.data(), input.data() + input.size()) == input.size();
+}
+
+// Decodes one multi-byte UTF-8 sequence starting at in (which must not be ASCII) and
+// returns the number of bytes consumed. Matches the utf8_decode DFA it replaces: an
+// invalid sequence is dropped along with the byte that broke it, and a sequence
+// truncated by the end of input is dropped. Returns with *valid false in both cases.
+static size_t DecodeUtf8Sequence(const unsigned char *in, const unsigned char *end, uint32_t *utf32, bool *valid)
+{
+    unsigned char lead = in[0];
+    size_t length;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+
+    if (lead >= 0xC2 && lead <= 0xDF)
     {
-        anyascii_string(utf8Input.c_str(), buffer.data());
-        output = std::string(buffer.data());
-        return true;
+        length = 2;
+        *utf32 = lead & 0x1F;
     }
-    catch (...)
+    else if (lead >= 0xE0 && lead <= 0xEF)
     {
-        output = std::string();
-        return false;
+        length = 3;
+        *utf32 = lead & 0x0F;
+        if (lead == 0xE0)
+        {
+            lo = 0xA0; // Overlong
+        }
+        else if (lead == 0xED)
+        {
+            hi = 0x9F; // Surrogates
+        }
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        *utf32 = lead & 0x07;
+        if (lead == 0xF0)
+        {
+            lo = 0x90; // Overlong
+        }
+        else if (lead == 0xF4)
+        {
+            hi = 0x8F; // Above U+10FFFF
+        }
+    }
+    else
+    {
+        *valid = false;
+        return 1;
+    }
+
+    for (size_t i = 1; i < length; ++i)
+    {
+        if (in + i == end)
+        {
+            *valid = false;
+            return i;
+        }
+
+        unsigned char c = in[i];
+        if (c < lo || c > hi)
+        {
+            *valid = false;
+            return i + 1;
+        }
+
+        *utf32 = (*utf32 << 6) | (c & 0x3F);
+        lo = 0x80;
+        hi = 0xBF;
     }
+
+    *valid = true;
+    return length;
 }
 
-std::string SanitizeForShell(const std::string &input)
+// Hit/miss totals from threads whose codepoint caches have been destroyed
+static std::atomic<uint64_t> CodepointCacheRetiredHits(0);
+static std::atomic<uint64_t> CodepointCacheRetiredMisses(0);
+
+// Direct-mapped cache of recent anyascii() results, 256 entries of 16 bytes so the
+// whole thing stays in L1. Results too long to store inline are never cached.
+class CodepointCache
 {
-    // Characters that are dangerous in shell contexts:
-    // ; $ ` | & > < ' " \ * ? [ ] ( ) ! ~ # and newlines
-    static const std::string dangerous = ";$`|&><'\"\\*?[]()!~#\n\r";
-    std::string result;
-    result.reserve(input.length());
+    static constexpr uint32_t Empty = UINT32_MAX;
+    static constexpr size_t MaxLength = 11;
+
+    struct Entry
+    {
+        uint32_t Codepoint;
+        uint8_t Length;
+        char Ascii[MaxLength];
+    };
+
+    Entry entries_[256];
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
 
-    for (char c : input)
+public:
+    CodepointCache()
     {
-        if (dangerous.find(c) != std::string::npos)
+        for (auto &entry : entries_)
         {
-            result += '_';
+            entry.Codepoint = Empty;
         }
-        else
+    }
+
+    ~CodepointCache()
+    {
+        CodepointCacheRetiredHits += hits_;
+        CodepointCacheRetiredMisses += misses_;
+    }
+
+    size_t Lookup(uint32_t utf32, const char **ascii)
+    {
+        // Multiplicative hash, so neighbouring blocks (e.g. Cyrillic and Kana) don't collide
+        Entry &entry = entries_[(utf32 * UINT32_C(0x9E3779B1)) >> 24];
+        if (entry.Codepoint == utf32)
+        {
+            ++hits_;
+            *ascii = entry.Ascii;
+            return entry.Length;
+        }
+
+        ++misses_;
+        size_t length = anyascii(utf32, ascii);
+        if (length <= MaxLength)
+        {
+            entry.Codepoint = utf32;
+            entry.Length = static_cast<uint8_t>(length);
+            memcpy(entry.Ascii, *ascii, length);
+        }
+        return length;
+    }
+
+    uint64_t Hits() const
+    {
+        return hits_;
+    }
+
+    uint64_t Misses() const
+    {
+        return misses_;
+    }
+};
+
+static thread_local CodepointCache HotCodepoints;
+
+CodepointCacheStats GetCodepointCacheStats()
+{
+    return {CodepointCacheRetiredHits + HotCodepoints.Hits(), CodepointCacheRetiredMisses + HotCodepoints.Misses()};
+}
+
+// Characters that are dangerous in shell contexts:
+// ; $ ` | & > < ' " \ * ? [ ] ( ) ! ~ # and newlines
+static constexpr char ShellMetachars[] = ";$`|&><'\"\\*?[]()!~#\n\r";
+
+// 256-bit classification bitmap of the metacharacters, built at compile time
+struct ByteBitmap
+{
+    uint64_t Bits[4] = {};
+
+    constexpr bool Test(unsigned char c) const
+    {
+        return (Bits[c >> 6] >> (c & 63)) & 1;
+    }
+};
+
+static constexpr ByteBitmap MakeShellMetacharBitmap()
+{
+    ByteBitmap bitmap;
+    for (const char *p = ShellMetachars; *p; ++p)
+    {
+        unsigned char c = static_cast<unsigned char>(*p);
+        bitmap.Bits[c >> 6] |= uint64_t(1) << (c & 63);
+    }
+    return bitmap;
+}
+
+static constexpr ByteBitmap ShellMetacharBitmap = MakeShellMetacharBitmap();
+
+// Maps every byte to itself, except shell metacharacters which map to '_'
+struct ByteMap
+{
+    char Map[256] = {};
+};
+
+static constexpr ByteMap MakeShellSafeMap()
+{
+    ByteMap map;
+    for (int c = 0; c < 256; ++c)
+    {
+        map.Map[c] = ShellMetacharBitmap.Test(static_cast<unsigned char>(c)) ? '_' : static_cast<char>(c);
+    }
+    return map;
+}
+
+static constexpr ByteMap ShellSafe = MakeShellSafeMap();
+
+#if defined(__AVX2__) || defined(ASCIIRENAME_SSE2)
+// The metacharacters as inclusive byte ranges, so the vector classifier needs one
+// subtract and one saturating compare per range
+struct ByteRange
+{
+    unsigned char Lo;
+    unsigned char Hi;
+};
+
+static constexpr ByteRange ShellMetacharRanges[] = {
+    {0x0A, 0x0A}, {0x0D, 0x0D}, {0x21, 0x24}, {0x26, 0x2A}, {0x3B, 0x3C},
+    {0x3E, 0x3F}, {0x5B, 0x5D}, {0x60, 0x60}, {0x7C, 0x7C}, {0x7E, 0x7E},
+};
+
+static constexpr bool ShellMetacharRangesMatchBitmap()
+{
+    for (int c = 0; c < 256; ++c)
+    {
+        bool inRange = false;
+        for (const auto &range : ShellMetacharRanges)
         {
-            result += c;
+            inRange = inRange || (c >= range.Lo && c <= range.Hi);
         }
+        if (inRange != ShellMetacharBitmap.Test(static_cast<unsigned char>(c)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(ShellMetacharRangesMatchBitmap(), "ShellMetacharRanges is out of sync with ShellMetachars");
+
+// Returns a byte mask with 0xFF in each lane holding a shell metacharacter
+static inline __m128i ClassifyShellMetachars(__m128i chunk)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i result = zero;
+    for (const auto &range : ShellMetacharRanges)
+    {
+        __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8(static_cast<char>(range.Lo)));
+        __m128i over = _mm_subs_epu8(offset, _mm_set1_epi8(static_cast<char>(range.Hi - range.Lo)));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(over, zero));
     }
     return result;
 }
+#endif
 
-std::vector<std::filesystem::path> GetRenameableComponents(
-#ifdef _WIN32
-    const std::wstring &pathStr
-#else
-    const std::string &pathStr
+// Returns the offset of the first shell metacharacter in [p, end), or end - p if none
+static size_t FindShellMetachar(const char *p, const char *end)
+{
+    const char *start = p;
+
+#if defined(__AVX2__) || defined(ASCIIRENAME_SSE2)
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(ClassifyShellMetachars(chunk)));
+        if (mask != 0)
+        {
+            return static_cast<size_t>(p - start) + CountTrailingZeros(mask);
+        }
+    }
 #endif
-)
+
+    while (p < end && !ShellMetacharBitmap.Test(static_cast<unsigned char>(*p)))
+    {
+        ++p;
+    }
+
+    return static_cast<size_t>(p - start);
+}
+
+// Output cursor over a caller-owned buffer. Writes while there is room and keeps
+// counting past the end, so a too-small buffer still yields the needed length.
+// When sanitizing, metacharacters are replaced as they are written.
+class AsciiWriter
 {
-    std::vector<std::filesystem::path> result;
-    std::filesystem::path fullPath(pathStr);
-    std::filesystem::path current;
+    char *out_;
+    size_t capacity_;
+    size_t length_ = 0;
+    bool sanitize_;
+
+public:
+    AsciiWriter(char *out, size_t capacity, bool sanitize) : out_(out), capacity_(capacity), sanitize_(sanitize)
+    {
+    }
+
+    void Append(const char *s, size_t n)
+    {
+        if (length_ < capacity_)
+        {
+            char *dest = out_ + length_;
+            size_t count = std::min(n, capacity_ - length_);
+            if (sanitize_)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    dest[i] = ShellSafe.Map[static_cast<unsigned char>(s[i])];
+                }
+            }
+            else
+            {
+                memcpy(dest, s, count);
+            }
+        }
+        length_ += n;
+    }
 
-    for (const auto &component : fullPath)
+    size_t Length() const
+    {
+        return length_;
+    }
+};
+
+// Adapted from https://github.com/anyascii/anyascii/blob/0.3.1/impl/c/test.c
+// ASCII runs are found a vector at a time and copied straight through, so only
+// non-ASCII codepoints are decoded and looked up.
+static void anyascii_string(const char *in, const char *end, AsciiWriter &out)
+{
+    while (in < end)
     {
-        auto compStr = component.string();
+        size_t run = AsciiRunLength(in, end);
+        out.Append(in, run);
+        in += run;
 
-        // Skip root directory markers
-        if (compStr == "/" || compStr == "\\")
+        if (in == end)
         {
-            current /= component;
-            continue;
+            break;
         }
 
-        // Skip relative path markers
-        if (compStr == "." || compStr == "..")
+        uint32_t utf32;
+        bool valid;
+        in += DecodeUtf8Sequence(reinterpret_cast<const unsigned char *>(in),
+                                 reinterpret_cast<const unsigned char *>(end), &utf32, &valid);
+        if (valid)
         {
-            current /= component;
-            continue;
+            const char *r;
+            size_t rlen = HotCodepoints.Lookup(utf32, &r);
+            out.Append(r, rlen);
         }
+    }
+}
+
+static size_t Transliterate(std::string_view utf8Input, char *output, size_t outputSize, bool sanitize)
+{
+    AsciiWriter writer(output, outputSize, sanitize);
+    anyascii_string(utf8Input.data(), utf8Input.data() + utf8Input.length(), writer);
+    return writer.Length();
+}
 
-        // Skip Windows drive letters (e.g., "C:")
-        if (compStr.length() == 2 && compStr[1] == ':')
+static bool TransliterateToString(std::string const &utf8Input, std::string &output, bool sanitize)
+{
+    // Fast path: pure ASCII transliterates to itself, so skip the decode and the buffer
+    if (IsAscii(utf8Input))
+    {
+        output = utf8Input;
+        if (sanitize)
         {
-            current /= component;
-            continue;
+            SanitizeForShellInPlace(output.data(), output.length());
         }
+        return true;
+    }
 
-        current /= component;
-        result.push_back(current);
+    try
+    {
+        // Measure first, then write straight into an exactly sized output. Expansions
+        // can't overrun and no worst-case buffer is needed.
+        size_t length = Transliterate(utf8Input, nullptr, 0, sanitize);
+        output.resize(length);
+        Transliterate(utf8Input, output.data(), output.length(), sanitize);
+        return true;
+    }
+    catch (...)
+    {
+        output = std::string();
+        return false;
     }
+}
 
-    // Reverse for bottom-up order (deepest paths first)
-    std::reverse(result.begin(), result.end());
-    return result;
+size_t TryGetAscii(std::string_view utf8Input, char *output, size_t outputSize)
+{
+    return Transliterate(utf8Input, output, outputSize, false);
+}
+
+bool TryGetAscii(std::string const &utf8Input, std::string &output)
+{
+    return TransliterateToString(utf8Input, output, false);
+}
+
+size_t TryGetSanitizedAscii(std::string_view utf8Input, char *output, size_t outputSize)
+{
+    return Transliterate(utf8Input, output, outputSize, true);
+}
+
+bool TryGetSanitizedAscii(std::string const &utf8Input, std::string &output)
+{
+    return TransliterateToString(utf8Input, output, true);
+}
+
+TransliterationCache::TransliterationCache(size_t capacity) : capacity_(capacity)
+{
+}
+
+bool TransliterationCache::TryGetSanitizedAscii(std::string const &utf8Input, std::string &output)
+{
+    if (IsAscii(utf8Input))
+    {
+        return AsciiRename::TryGetSanitizedAscii(utf8Input, output);
+    }
+
+    auto it = entries_.find(utf8Input);
+    if (it != entries_.end())
+    {
+        ++hits_;
+        output = it->second;
+        return true;
+    }
+
+    ++misses_;
+    if (!AsciiRename::TryGetSanitizedAscii(utf8Input, output))
+    {
+        return false;
+    }
+
+    if (entries_.size() >= capacity_)
+    {
+        entries_.clear();
+    }
+    entries_.emplace(utf8Input, output);
+    return true;
+}
+
+std::string_view AsciiBatch::operator[](size_t i) const
+{
+    return std::string_view(Arena.data() + Offsets[i], Offsets[i + 1] - Offsets[i]);
+}
+
+void TransliterateBatch(const std::string_view *names, size_t count, AsciiBatch &batch)
+{
+    // First pass records each name's exact output length as its end offset
+    batch.Offsets.resize(count + 1);
+    batch.Offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        batch.Offsets[i + 1] = batch.Offsets[i] + TryGetAscii(names[i], nullptr, 0);
+    }
+
+    // Second pass writes into an arena of exactly the total size
+    batch.Arena.resize(batch.Offsets[count]);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t offset = batch.Offsets[i];
+        TryGetAscii(names[i], batch.Arena.data() + offset, batch.Offsets[i + 1] - offset);
+    }
+}
+
+size_t SanitizeForShellInPlace(char *data, size_t length)
+{
+    char *p = data + FindShellMetachar(data, data + length);
+    char *end = data + length;
+    size_t replaced = 0;
+
+#if defined(__AVX2__) || defined(ASCIIRENAME_SSE2)
+    __m128i underscore = _mm_set1_epi8('_');
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i mask = ClassifyShellMetachars(chunk);
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(mask));
+        if (bits != 0)
+        {
+            chunk = _mm_or_si128(_mm_and_si128(mask, underscore), _mm_andnot_si128(mask, chunk));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), chunk);
+            for (; bits != 0; bits &= bits - 1)
+            {
+                ++replaced;
+            }
+        }
+    }
+#endif
+
+    for (; p < end; ++p)
+    {
+        if (ShellMetacharBitmap.Test(static_cast<unsigned char>(*p)))
+        {
+            *p = '_';
+            ++replaced;
+        }
+    }
+
+    return replaced;
+}
+
+bool NeedsRename(std::string_view utf8Name)
+{
+    const char *begin = utf8Name.data();
+    return !IsAscii(utf8Name) || FindShellMetachar(begin, begin + utf8Name.size()) != utf8Name.size();
+}
+
+std::string SanitizeForShell(const std::string &input)
+{
+    // Scan before copying, so the copy is only sanitized from the first metacharacter
+    // on and a clean prefix isn't scanned twice
+    size_t first = FindShellMetachar(input.data(), input.data() + input.length());
+    std::string output(input);
+    if (first != input.length())
+    {
+        SanitizeForShellInPlace(output.data() + first, output.length() - first);
+    }
+    return output;
+}
+
+std::string SanitizeForShell(std::string &&input)
+{
+    SanitizeForShellInPlace(input.data(), input.length());
+    return std::move(input);
+}
+
+bool IsRenameableComponent(std::filesystem::path const &component)
+{
+    auto compStr = component.string();
+
+    // Skip root directory markers
+    if (compStr == "/" || compStr == "\\")
+    {
+        return false;
+    }
+
+    // Skip relative path markers
+    if (compStr == "." || compStr == "..")
+    {
+        return false;
+    }
+
+    // Skip Windows drive letters (e.g., "C:")
+    return !(compStr.length() == 2 && compStr[1] == ':');
 }
 
 } // namespace AsciiRename
@@ -4,8 +4,11 @@
 #ifndef HELPERS_H
 #define HELPERS_H
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace AsciiRename
@@ -27,21 +30,99 @@ bool TryGetUtf8(
 #endif
     std::string &output);
 
+// Returns true if every byte of the input is 7-bit ASCII (vectorized where available)
+bool IsAscii(std::string_view input);
+
 bool TryGetAscii(std::string const &utf8Input, std::string &output);
 
+// Transliterate into a caller-owned buffer without allocating. Returns the full length
+// of the result, which is not null-terminated. If that is more than outputSize, only
+// the first outputSize chars were written and the call should be repeated with a
+// buffer of at least the returned size. Pass a null buffer and 0 to just measure.
+size_t TryGetAscii(std::string_view utf8Input, char *output, size_t outputSize);
+
+struct CodepointCacheStats
+{
+    uint64_t Hits;
+    uint64_t Misses;
+};
+
+// Hit/miss counts of the per-thread cache in front of anyascii(), summed over the
+// calling thread and every thread that has exited
+CodepointCacheStats GetCodepointCacheStats();
+
+// Transliterate and shell-sanitize in a single pass; equivalent to TryGetAscii
+// followed by SanitizeForShell without the intermediate string
+bool TryGetSanitizedAscii(std::string const &utf8Input, std::string &output);
+
+// Caller-buffer form of TryGetSanitizedAscii, with the same contract as the
+// caller-buffer TryGetAscii
+size_t TryGetSanitizedAscii(std::string_view utf8Input, char *output, size_t outputSize);
+
+// Bounded memo from raw UTF-8 name to its sanitized ASCII form. The same names repeat
+// all over a media tree (disc, album and artist folders), so each distinct one is
+// converted once. Pure ASCII names skip the cache, as converting them is cheaper than
+// hashing them. When full, the cache is cleared and refilled.
+class TransliterationCache
+{
+    std::unordered_map<std::string, std::string> entries_;
+    size_t capacity_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+
+public:
+    explicit TransliterationCache(size_t capacity = 1 << 16);
+
+    // Same contract as the free TryGetSanitizedAscii
+    bool TryGetSanitizedAscii(std::string const &utf8Input, std::string &output);
+
+    size_t Hits() const
+    {
+        return hits_;
+    }
+
+    size_t Misses() const
+    {
+        return misses_;
+    }
+};
+
+// Transliterated names packed end to end in one arena; name i is
+// Arena[Offsets[i], Offsets[i + 1]).
+struct AsciiBatch
+{
+    std::vector<char> Arena;
+    std::vector<size_t> Offsets;
+
+    size_t size() const
+    {
+        return Offsets.empty() ? 0 : Offsets.size() - 1;
+    }
+
+    std::string_view operator[](size_t i) const;
+};
+
+// Transliterate a batch of UTF-8 names into one contiguous arena. Replaces the
+// batch's previous contents; reusing a batch across calls reuses its storage.
+void TransliterateBatch(const std::string_view *names, size_t count, AsciiBatch &batch);
+
 // Sanitize a string by replacing shell metacharacters with underscores
 // Handles: ; $ ` | & > < ' " \ * ? [ ] ( ) ! ~ # and newlines
 std::string SanitizeForShell(const std::string &input);
 
-// Extract path components that should be renamed, in bottom-up order
-// (deepest components first). Skips root directories, drive letters, and . / ..
-std::vector<std::filesystem::path> GetRenameableComponents(
-#ifdef _WIN32
-    const std::wstring &pathStr
-#else
-    const std::string &pathStr
-#endif
-);
+// Sanitizes in place, so clean input comes back without a copy
+std::string SanitizeForShell(std::string &&input);
+
+// Sanitize a buffer in place, a vector at a time where available. Returns the number
+// of characters replaced; 0 means the input was already shell-safe.
+size_t SanitizeForShellInPlace(char *data, size_t length);
+
+// Cheap check for whether TryGetSanitizedAscii would change a name: true unless it
+// is pure ASCII with no shell metacharacters
+bool NeedsRename(std::string_view utf8Name);
+
+// Whether a path component can be renamed: not a root directory, drive letter, . or ..
+bool IsRenameableComponent(std::filesystem::path const &component);
 
 } // namespace AsciiRename
 
@@ -2,16 +2,46 @@
 // Licensed under the MIT License.
 
 #include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
-#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include <libpu8.h>
 
+#include "componenttree.h"
+#include "filter.h"
 #include "helpers.h"
+#include "renameops.h"
+#include "scheduler.h"
+#include "walker.h"
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+#include "scancache.h"
+#endif
+
+#ifdef ASCII_RENAME_DIR_HANDLES
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "dirhandles.h"
+#endif
+
+#ifdef ASCII_RENAME_IO_URING
+#ifndef ASCII_RENAME_DIR_HANDLES
+#error "ASCII_RENAME_IO_URING requires ASCII_RENAME_DIR_HANDLES"
+#endif
+
+#include <unordered_set>
+
+#include "uring.h"
+#endif
 
 #ifndef VERSION_STR
 #define VERSION_STR "0.0.0"
@@ -34,91 +64,570 @@ void ShowVersion()
 void ShowHelp()
 {
     std::cout << "Usage: ascii-rename [options...] [paths...]\n";
-    std::cout << "-h, --help       Show this help and exit\n";
-    std::cout << "-n, --no-op      Show what would happen but don't actually rename path(s)\n";
-    std::cout << "-o, --overwrite  Overwrite existing paths(s)\n";
-    std::cout << "-r, --recursive  Rename files and subdirectories recursively\n";
-    std::cout << "-v, --verbose    Make the output more verbose\n";
-    std::cout << "-V, --version    Show version number and exit\n";
+    std::cout << "-c, --cache FILE       Skip directories found clean and unchanged by earlier runs (Linux)\n";
+    std::cout << "-d, --max-depth N      With -r, go no more than N levels below each path\n";
+    std::cout << "-e, --exclude GLOB     With -r, skip entries matching GLOB and don't enter such directories\n";
+    std::cout << "-h, --help             Show this help and exit\n";
+    std::cout << "-i, --include GLOB     With -r, only rename files matching GLOB (directories are unaffected)\n";
+    std::cout << "-j, --jobs N           Scan and rename with N threads (default 1)\n";
+    std::cout << "-L, --follow-symlinks  Descend into symlinked directories (default)\n";
+    std::cout << "-n, --no-op            Show what would happen but don't actually rename path(s)\n";
+    std::cout << "-o, --overwrite        Overwrite existing paths(s)\n";
+    std::cout << "-P, --no-follow        Rename symlinks but don't descend into them\n";
+    std::cout << "-r, --recursive        Rename files and subdirectories recursively\n";
+    std::cout << "-s, --stream           With -r, rename each directory's contents as soon as it's scanned\n";
+    std::cout << "-u, --io-uring         Batch filesystem calls through io_uring where available (Linux)\n";
+    std::cout << "-v, --verbose          Make the output more verbose\n";
+    std::cout << "-V, --version          Show version number and exit\n";
+    std::cout << "-x, --one-file-system  With -r, don't descend into other file systems (Linux)\n";
 }
 
-struct PathItem
+using AsciiRename::RenameOp;
+using AsciiRename::RenameOpSet;
+
+// Upper bounds of the numeric options
+static constexpr unsigned MaxJobs = 1024;
+static constexpr unsigned MaxDepthLimit = 65535;
+
+// Parse an integer option value from 1 to max
+static bool TryParsePositive(const char *str, unsigned max, unsigned &value)
 {
-#ifdef _WIN32
-    std::wstring Path;
-#else
-    std::string Path;
-#endif
-    bool SubsScanned;
-};
+    char *end = nullptr;
+    unsigned long parsed = std::strtoul(str, &end, 10);
+    if (end == str || *end != '\0' || parsed == 0 || parsed > max)
+    {
+        return false;
+    }
+    value = static_cast<unsigned>(parsed);
+    return true;
+}
 
-// Tracks renamed paths so we can resolve paths that reference renamed ancestors
-class PathTracker
+// Whether the last component of a path would change when renamed
+static bool NeedsRename(const std::filesystem::path &path)
 {
-    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> renames_;
+    auto filenameStr = std::string();
+    return !AsciiRename::TryGetUtf8(path.filename().native(), filenameStr) || AsciiRename::NeedsRename(filenameStr);
+}
 
-public:
-    // Resolve a path by applying all recorded renames to its ancestors
-    std::filesystem::path resolve(const std::filesystem::path &original) const
+// Queue a rename op for every renameable component of a path that needs renaming
+static void AddRenameOps(AsciiRename::ComponentTree &tree, RenameOpSet &allOps,
+                         const std::filesystem::path &path)
+{
+    RenameOp node = AsciiRename::ComponentTree::Root;
+    for (const auto &component : path)
     {
-        std::filesystem::path result = original;
-        for (const auto &[from, to] : renames_)
+        node = tree.Intern(node, component.native(), AsciiRename::IsRenameableComponent(component));
+        if (tree.IsRenameable(node) && NeedsRename(component))
         {
-            // Check if 'result' starts with 'from'
-            auto resultIt = result.begin();
-            auto fromIt = from.begin();
-            bool matches = true;
+            allOps.Add(node);
+        }
+    }
+}
 
-            while (fromIt != from.end())
+// Queue a rename op for each entry of a walked directory whose name will change. Its
+// ancestors are other entries or components of the walk's root, which get their own ops.
+static void AddEntryRenameOps(AsciiRename::ComponentTree &tree, std::vector<RenameOp> &allOps,
+                              const std::filesystem::path &directory,
+                              const std::vector<AsciiRename::WalkEntry> &entries)
+{
+    auto parent = AsciiRename::ComponentTree::Root;
+    for (const auto &entry : entries)
+    {
+        if (entry.NeedsRename)
+        {
+            if (parent == AsciiRename::ComponentTree::Root)
             {
-                if (resultIt == result.end() || *resultIt != *fromIt)
-                {
-                    matches = false;
-                    break;
-                }
-                ++resultIt;
-                ++fromIt;
+                parent = tree.Intern(directory);
             }
+            allOps.push_back(tree.Intern(parent, entry.Path.filename().native()));
+        }
+    }
+}
 
-            if (matches)
-            {
-                // Replace the 'from' prefix with 'to'
-                std::filesystem::path updated = to;
-                while (resultIt != result.end())
-                {
-                    updated /= *resultIt;
-                    ++resultIt;
-                }
-                result = updated;
-            }
+#ifdef ASCII_RENAME_DIR_HANDLES
+// Directory handles kept open at once, beyond those in use, well under the usual
+// default fd limit
+static constexpr size_t DirectoryHandleLimit = 256;
+#endif
+
+// State shared by every op processed in a run
+struct RenameRun
+{
+    bool Noop = false;
+    bool Overwrite = false;
+    bool Verbose = false;
+    // Every path seen, with renames applied as they happen
+    AsciiRename::ComponentTree Tree;
+    AsciiRename::TransliterationCache Transliterations;
+    int Renames = 0;
+    int Skipped = 0;
+#ifdef ASCII_RENAME_DIR_HANDLES
+    // Ops address their entries relative to their parent directory's handle
+    AsciiRename::DirectoryHandles Handles{DirectoryHandleLimit};
+#endif
+    // Guards everything above when ops run on several threads
+    std::mutex Lock;
+#ifdef ASCII_RENAME_IO_URING
+    // Batches filesystem calls when set
+    std::unique_ptr<AsciiRename::IoUring> Ring;
+#endif
+};
+
+// An op with its current and new paths worked out
+struct PlannedRename
+{
+    RenameOp Node;
+    std::filesystem::path CurrentPath;
+    std::filesystem::path NewPath;
+    std::string CurrentPathStr;
+    std::string NewPathStr;
+    std::string FilenameStr;
+    bool Converted = false;
+#ifdef ASCII_RENAME_DIR_HANDLES
+    // The parent directory's handle and the names within it, or AT_FDCWD and the
+    // full paths if the handle couldn't be opened
+    int DirFd = AT_FDCWD;
+    std::filesystem::path Name;
+    std::filesystem::path NewName;
+#endif
+};
+
+// What the filesystem says about a planned rename
+struct RenameChecks
+{
+    bool SourceExists = false;
+    bool TargetExists = false;
+    // Source and target are the same file (e.g. a case-insensitive match)
+    bool SameFile = false;
+};
+
+static void PlanRename(RenameRun &run, const RenameOp &op, PlannedRename &plan)
+{
+    plan.Node = op;
+
+    // The current path (may have been affected by earlier renames)
+    plan.CurrentPath = run.Tree.Path(op);
+    AsciiRename::TryGetUtf8(plan.CurrentPath.native(), plan.CurrentPathStr);
+
+    // Get ASCII + sanitized version of the filename only
+    AsciiRename::TryGetUtf8(plan.CurrentPath.filename().native(), plan.FilenameStr);
+
+    auto asciiFilename = std::string();
+    plan.Converted = run.Transliterations.TryGetSanitizedAscii(plan.FilenameStr, asciiFilename);
+    if (plan.Converted)
+    {
+        // Construct new path
+        plan.NewPath = plan.CurrentPath.parent_path() / asciiFilename;
+        AsciiRename::TryGetUtf8(plan.NewPath.native(), plan.NewPathStr);
+    }
+
+#ifdef ASCII_RENAME_DIR_HANDLES
+    plan.DirFd = run.Handles.Acquire(run.Tree, run.Tree.Parent(op));
+    if (plan.DirFd != -1)
+    {
+        plan.Name = plan.CurrentPath.filename();
+        plan.NewName = plan.NewPath.filename();
+    }
+    else
+    {
+        // Fall back to full paths, which fail the same way if the parent is gone
+        plan.DirFd = AT_FDCWD;
+        plan.Name = plan.CurrentPath;
+        plan.NewName = plan.NewPath;
+    }
+#endif
+}
+
+// Releases anything PlanRename acquired
+static void UnplanRename([[maybe_unused]] RenameRun &run, [[maybe_unused]] const PlannedRename &plan)
+{
+#ifdef ASCII_RENAME_DIR_HANDLES
+    if (plan.DirFd != AT_FDCWD)
+    {
+        run.Handles.Release(run.Tree.Parent(plan.Node));
+    }
+#endif
+}
+
+// Whether the target has to be checked for a collision before renaming
+static bool NeedsTargetCheck(const RenameRun &run, const PlannedRename &plan)
+{
+    return plan.Converted && plan.CurrentPathStr != plan.NewPathStr && !run.Overwrite;
+}
+
+// Reports everything up to the rename itself. Returns true if the rename should go
+// ahead (or, in no-op mode, be reported as if it had).
+static bool ApproveRename(RenameRun &run, const PlannedRename &plan, const RenameChecks &checks)
+{
+    if (run.Verbose)
+    {
+        std::cout << "Processing \"" << plan.CurrentPathStr << "\"...\n";
+    }
+
+    // Check if path still exists
+    if (!checks.SourceExists)
+    {
+        if (run.Verbose)
+        {
+            std::cout << "Path no longer exists, skipping \"" << plan.CurrentPathStr << "\"...\n";
         }
-        return result;
+        return false;
     }
 
-    void record(const std::filesystem::path &from, const std::filesystem::path &to)
+    if (!plan.Converted)
     {
-        renames_.emplace_back(from, to);
+        std::cerr << "ERROR: Unable convert \"" << plan.FilenameStr << "\" to ASCII, skipping.\n";
+        ++run.Skipped;
+        return false;
     }
-};
 
-// Represents a single rename operation
-struct RenameOp
+    // Check if rename is needed
+    if (plan.CurrentPathStr == plan.NewPathStr)
+    {
+        if (run.Verbose)
+        {
+            std::cout << "No need to rename \"" << plan.CurrentPathStr << "\".\n";
+        }
+        return false;
+    }
+
+    // Check for collision
+    if (checks.TargetExists && !run.Overwrite)
+    {
+        // Special case: if source and dest are the same (case-insensitive match on some filesystems)
+        // we should still allow the rename
+        if (!checks.SameFile)
+        {
+            std::cerr << "ERROR: \"" << plan.NewPathStr << "\" already exists.\n";
+            std::cerr << "ERROR: Specify --overwrite to overwrite.\n";
+            ++run.Skipped;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Reports, counts and records an approved rename once it has been attempted. In no-op
+// mode nothing is attempted, and the rename is reported and recorded as if it had
+// succeeded.
+static void FinishRename(RenameRun &run, const PlannedRename &plan, bool succeeded)
+{
+    if (run.Noop)
+    {
+        std::cout << "Would have renamed \"" << plan.CurrentPathStr << "\" to \"" << plan.NewPathStr << "\"...\n";
+        ++run.Renames;
+        // Record the rename for path resolution even in no-op mode
+        run.Tree.Rename(plan.Node, plan.NewPath.filename().native());
+        return;
+    }
+
+    std::cout << "Renaming \"" << plan.CurrentPathStr << "\" to \"" << plan.NewPathStr << "\"...\n";
+    if (succeeded)
+    {
+        ++run.Renames;
+        // Record the rename for path resolution
+        run.Tree.Rename(plan.Node, plan.NewPath.filename().native());
+    }
+    else
+    {
+        std::cerr << "ERROR: File system error, unable to rename \"" << plan.CurrentPathStr << "\" to \""
+                  << plan.NewPathStr << "\".\n";
+        ++run.Skipped;
+    }
+}
+
+#ifdef ASCII_RENAME_DIR_HANDLES
+// Asks the filesystem about a planned rename, by name within the parent's handle
+static void CheckRename(const PlannedRename &plan, bool needsTargetCheck, RenameChecks &checks)
+{
+    struct stat source;
+    struct stat target;
+    checks.SourceExists = fstatat(plan.DirFd, plan.Name.c_str(), &source, 0) == 0;
+    if (checks.SourceExists && needsTargetCheck)
+    {
+        checks.TargetExists = fstatat(plan.DirFd, plan.NewName.c_str(), &target, 0) == 0;
+        checks.SameFile = checks.TargetExists && source.st_dev == target.st_dev && source.st_ino == target.st_ino;
+    }
+}
+
+static bool RenameEntry(const PlannedRename &plan)
+{
+    return renameat(plan.DirFd, plan.Name.c_str(), plan.DirFd, plan.NewName.c_str()) == 0;
+}
+#else
+// Asks the filesystem about a planned rename. Errors count as missing paths rather
+// than throwing, since ops may run on walker threads.
+static void CheckRename(const PlannedRename &plan, bool needsTargetCheck, RenameChecks &checks)
+{
+    std::error_code ec;
+    checks.SourceExists = std::filesystem::exists(plan.CurrentPath, ec);
+    if (checks.SourceExists && needsTargetCheck)
+    {
+        checks.TargetExists = std::filesystem::exists(plan.NewPath, ec);
+        checks.SameFile = checks.TargetExists && std::filesystem::equivalent(plan.CurrentPath, plan.NewPath, ec);
+    }
+}
+
+static bool RenameEntry(const PlannedRename &plan)
+{
+    std::error_code ec;
+    std::filesystem::rename(plan.CurrentPath, plan.NewPath, ec);
+    return !ec;
+}
+#endif
+
+// Process one op with synchronous filesystem calls
+static void ProcessOp(RenameRun &run, const RenameOp &op)
+{
+    PlannedRename plan;
+    bool needsTargetCheck;
+    {
+        std::lock_guard<std::mutex> lock(run.Lock);
+        PlanRename(run, op, plan);
+        needsTargetCheck = NeedsTargetCheck(run, plan);
+    }
+
+    // Filesystem calls are made outside the lock so ops on other threads can overlap them
+    RenameChecks checks;
+    CheckRename(plan, needsTargetCheck, checks);
+
+    bool approved;
+    {
+        std::lock_guard<std::mutex> lock(run.Lock);
+        approved = ApproveRename(run, plan, checks);
+    }
+
+    bool succeeded = approved && !run.Noop && RenameEntry(plan);
+
+    std::lock_guard<std::mutex> lock(run.Lock);
+    if (approved)
+    {
+        FinishRename(run, plan, succeeded);
+    }
+    UnplanRename(run, plan);
+}
+
+#ifdef ASCII_RENAME_IO_URING
+// Bound on calls in flight at once
+static constexpr unsigned IoUringDepth = 256;
+
+// Result slot of a batched call the ring never completed
+static constexpr int NotCompleted = 1;
+
+// Process a batch of ops at the same depth. None is an ancestor of another, so all
+// their paths can be planned up front, then every statx submitted at once, then
+// every approved rename. Returns how many of the ops were processed: fewer than
+// count if the ring failed before any of them were decided, or if two renames onto
+// the same target have to be kept apart.
+static size_t ProcessBatch(RenameRun &run, AsciiRename::IoUring &ring, const RenameOp *ops, size_t count)
 {
-    std::filesystem::path sourcePath;
-    int depth; // For sorting - deeper paths first
+    std::vector<PlannedRename> plans(count);
+    std::vector<struct statx> stats(count * 2);
+    std::vector<int> results(count * 2, -EIO);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        PlanRename(run, ops[i], plans[i]);
+        ring.QueueStatx(plans[i].DirFd, plans[i].Name.c_str(), 0, STATX_INO, &stats[i * 2], i * 2);
+        if (NeedsTargetCheck(run, plans[i]))
+        {
+            ring.QueueStatx(plans[i].DirFd, plans[i].NewName.c_str(), 0, STATX_INO, &stats[i * 2 + 1], i * 2 + 1);
+        }
+    }
+
+    if (!ring.SubmitAndWait([&](uint64_t index, int result) { results[index] = result; }))
+    {
+        // Nothing has been decided or renamed yet, so the caller can redo the batch
+        for (const auto &plan : plans)
+        {
+            UnplanRename(run, plan);
+        }
+        return 0;
+    }
+
+    // Decide in op order. Sources and targets of renames approved earlier in the batch
+    // count as gone and taken, just as they would be had the ops run one at a time.
+    std::unordered_set<std::string> claimedSources;
+    std::unordered_set<std::string> claimedTargets;
+    std::vector<size_t> approved;
+    size_t decided = 0;
+    for (; decided < count; ++decided)
+    {
+        size_t i = decided;
+        const auto &plan = plans[i];
+        const auto &source = stats[i * 2];
+        const auto &target = stats[i * 2 + 1];
+
+        // Overwriting renames onto the same target would race in the kernel, so the
+        // later one waits for the next batch
+        if (run.Overwrite && !run.Noop && plan.Converted && claimedTargets.count(plan.NewPathStr) != 0)
+        {
+            break;
+        }
 
-    bool operator<(const RenameOp &other) const
+        RenameChecks checks;
+        checks.SourceExists = results[i * 2] == 0 && claimedSources.count(plan.CurrentPathStr) == 0;
+        checks.TargetExists = results[i * 2 + 1] == 0 || claimedTargets.count(plan.NewPathStr) != 0;
+        checks.SameFile = results[i * 2] == 0 && results[i * 2 + 1] == 0 &&
+                          source.stx_dev_major == target.stx_dev_major &&
+                          source.stx_dev_minor == target.stx_dev_minor && source.stx_ino == target.stx_ino;
+
+        if (!ApproveRename(run, plan, checks))
+        {
+            continue;
+        }
+
+        claimedSources.insert(plan.CurrentPathStr);
+        claimedTargets.insert(plan.NewPathStr);
+        if (run.Noop)
+        {
+            FinishRename(run, plan, false);
+        }
+        else
+        {
+            ring.QueueRenameat(plan.DirFd, plan.Name.c_str(), plan.DirFd, plan.NewName.c_str(), 0, i);
+            approved.push_back(i);
+        }
+    }
+
+    // Each rename is reported as it completes
+    std::vector<int> renameResults(count, NotCompleted);
+    ring.SubmitAndWait([&](uint64_t index, int result) {
+        renameResults[index] = result;
+        FinishRename(run, plans[index], result == 0);
+    });
+
+    // If the ring failed, the renames it never took are made directly
+    for (size_t i : approved)
     {
-        // Sort by depth descending (deeper paths first)
-        return depth > other.depth;
+        if (renameResults[i] == NotCompleted)
+        {
+            FinishRename(run, plans[i], RenameEntry(plans[i]));
+        }
     }
 
-    bool operator==(const RenameOp &other) const
+    for (const auto &plan : plans)
     {
-        return sourcePath == other.sourcePath;
+        UnplanRename(run, plan);
     }
+    return decided;
+}
+
+// Process ops in depth order, batching the filesystem calls of each depth through
+// io_uring. If the ring fails, the rest are processed with synchronous calls.
+static void ProcessOpsBatched(RenameRun &run, AsciiRename::IoUring &ring, const std::vector<RenameOp> &ops)
+{
+    // Each op queues up to two statx calls
+    size_t batchSize = std::max<size_t>(ring.Depth() / 2, 1);
+    for (size_t begin = 0; begin < ops.size();)
+    {
+        if (ring.Failed())
+        {
+            ProcessOp(run, ops[begin++]);
+            continue;
+        }
+
+        size_t end = begin + 1;
+        while (end < ops.size() && end - begin < batchSize && run.Tree.Depth(ops[end]) == run.Tree.Depth(ops[begin]))
+        {
+            ++end;
+        }
+        begin += ProcessBatch(run, ring, ops.data() + begin, end - begin);
+    }
+}
+#endif
+
+// Process ops in order, batched through io_uring if the run has a ring
+static void ProcessOps(RenameRun &run, const std::vector<RenameOp> &ops)
+{
+#ifdef ASCII_RENAME_IO_URING
+    if (run.Ring)
+    {
+        ProcessOpsBatched(run, *run.Ring, ops);
+        if (run.Ring->Failed())
+        {
+            if (run.Verbose)
+            {
+                std::cout << "io_uring failed, using synchronous filesystem calls.\n";
+            }
+            run.Ring.reset();
+        }
+        return;
+    }
+#endif
+    for (const auto &op : ops)
+    {
+        ProcessOp(run, op);
+    }
+}
+
+// Once a streamed directory's entries are renamed, their subtrees are finished, so their
+// nodes are dropped from the tree. Only the directories still being walked, and their
+// ancestors, stay in memory. Nodes queued for the final pass are kept.
+static void ReleaseEntryNodes(RenameRun &run, const RenameOpSet &allOps, const std::filesystem::path &directory,
+                              const std::vector<AsciiRename::WalkEntry> &entries)
+{
+    // Find the directory without interning it; if it isn't there, nor are its entries
+    auto parent = AsciiRename::ComponentTree::Root;
+    for (const auto &component : directory)
+    {
+        parent = run.Tree.Find(parent, component.native());
+        if (parent == AsciiRename::ComponentTree::Root)
+        {
+            return;
+        }
+    }
+
+    for (const auto &entry : entries)
+    {
+        // Only these are ever interned
+        if (!entry.IsDirectory && !entry.NeedsRename)
+        {
+            continue;
+        }
+
+        auto node = run.Tree.Find(parent, entry.Path.filename().native());
+        if (node != AsciiRename::ComponentTree::Root && !allOps.Contains(node))
+        {
+#ifdef ASCII_RENAME_DIR_HANDLES
+            // The id may be reused for another directory
+            run.Handles.Forget(node);
+#endif
+            run.Tree.Release(node);
+        }
+    }
+}
+
+// A directory argument to walk recursively
+struct WalkRoot
+{
+    std::filesystem::path Path;
+    // Resolved, so arguments naming the same directories can be compared
+    std::filesystem::path Canonical;
 };
 
+// Whether roots[i] is inside another root, or the same as an earlier one
+static bool IsInsideOtherRoot(const std::vector<WalkRoot> &roots, size_t i)
+{
+    const auto &path = roots[i].Canonical;
+    for (size_t j = 0; j < roots.size(); ++j)
+    {
+        const auto &other = roots[j].Canonical;
+        if (j == i || path.empty() || other.empty())
+        {
+            continue;
+        }
+
+        auto mismatch = std::mismatch(other.begin(), other.end(), path.begin(), path.end());
+        if (mismatch.first == other.end() && (mismatch.second != path.end() || j < i))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 int main_utf8(int argc, char **argv)
 {
     if (argc <= 1)
@@ -128,13 +637,18 @@ int main_utf8(int argc, char **argv)
     }
 
     // Process arguments
-    auto pathItems = std::list<PathItem>();
+    auto paths = std::vector<std::filesystem::path::string_type>();
 
     // Options
     bool noop = false;
     bool overwrite = false;
     bool recursive = false;
+    bool stream = false;
     bool verbose = false;
+    bool ioUring = false;
+    auto cachePath = std::filesystem::path::string_type();
+    AsciiRename::NameFilter filter;
+    AsciiRename::WalkOptions walkOptions;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -150,6 +664,49 @@ int main_utf8(int argc, char **argv)
             ShowVersion();
             return 0;
         }
+        else if (ArgEquals(arg, "-c", "--cache"))
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "ERROR: --cache requires a file. Run with --help for usage info.\n";
+                return -1;
+            }
+            cachePath = u8widen(argv[++i]);
+        }
+        else if (ArgEquals(arg, "-d", "--max-depth"))
+        {
+            if (i + 1 >= argc || !TryParsePositive(argv[i + 1], MaxDepthLimit, walkOptions.MaxDepth))
+            {
+                std::cerr << "ERROR: --max-depth requires a number from 1 to " << MaxDepthLimit
+                          << ". Run with --help for usage info.\n";
+                return -1;
+            }
+            ++i;
+        }
+        else if (ArgEquals(arg, "-e", "--exclude") || ArgEquals(arg, "-i", "--include"))
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "ERROR: --include and --exclude require a pattern. Run with --help for usage info.\n";
+                return -1;
+            }
+            auto &globs = ArgEquals(arg, "-e", "--exclude") ? filter.Exclude : filter.Include;
+            globs.Add(argv[++i]);
+        }
+        else if (ArgEquals(arg, "-j", "--jobs"))
+        {
+            if (i + 1 >= argc || !TryParsePositive(argv[i + 1], MaxJobs, walkOptions.Jobs))
+            {
+                std::cerr << "ERROR: --jobs requires a number from 1 to " << MaxJobs
+                          << ". Run with --help for usage info.\n";
+                return -1;
+            }
+            ++i;
+        }
+        else if (ArgEquals(arg, "-L", "--follow-symlinks"))
+        {
+            walkOptions.FollowSymlinks = true;
+        }
         else if (ArgEquals(arg, "-n", "--no-op"))
         {
             noop = true;
@@ -158,10 +715,31 @@ int main_utf8(int argc, char **argv)
         {
             overwrite = true;
         }
+        else if (ArgEquals(arg, "-P", "--no-follow"))
+        {
+            walkOptions.FollowSymlinks = false;
+        }
         else if (ArgEquals(arg, "-r", "--recursive"))
         {
             recursive = true;
         }
+        else if (ArgEquals(arg, "-s", "--stream"))
+        {
+            stream = true;
+        }
+        else if (ArgEquals(arg, "-u", "--io-uring"))
+        {
+            ioUring = true;
+        }
+        else if (ArgEquals(arg, "-x", "--one-file-system"))
+        {
+#ifdef __linux__
+            walkOptions.OneFileSystem = true;
+#else
+            std::cerr << "ERROR: --one-file-system isn't supported on this platform.\n";
+            return -1;
+#endif
+        }
         else if (ArgEquals(arg, "-v", "--verbose"))
         {
             verbose = true;
@@ -182,196 +760,184 @@ int main_utf8(int argc, char **argv)
         }
         else
         {
-            pathItems.push_back({arg, false});
+            paths.push_back(arg);
         }
     }
 
-    // Collect all rename operations from all path arguments
-    // This includes parent directories that need renaming
-    std::vector<RenameOp> allOps;
+    RenameRun run;
+    run.Noop = noop;
+    run.Overwrite = overwrite;
+    run.Verbose = verbose;
 
-    // First pass: expand recursive directories and collect all paths
-    while (!pathItems.empty())
+    if (ioUring)
     {
-        auto rawItem = pathItems.front();
-        pathItems.pop_front();
-
-        AsciiRename::TrimTrailingPathSeparator(rawItem.Path);
-
-        auto originalPath = std::filesystem::path(rawItem.Path);
-
-        if (!std::filesystem::exists(originalPath))
-        {
-            auto pathStr = std::string();
-            AsciiRename::TryGetUtf8(rawItem.Path, pathStr);
-            std::cerr << "ERROR: \"" << pathStr << "\" doesn't exist.\n";
-            continue;
-        }
-
-        // Handle recursive directory expansion
-        if (std::filesystem::is_directory(originalPath) && recursive && !rawItem.SubsScanned)
-        {
-            // Re-add directory with SubsScanned=true, then add children
-            pathItems.push_front({rawItem.Path, true});
-
-            for (const auto &child : std::filesystem::directory_iterator(originalPath))
-            {
-                pathItems.push_front({
-#ifdef _WIN32
-                    child.path().wstring(),
+#ifdef ASCII_RENAME_IO_URING
+        run.Ring = AsciiRename::IoUring::TryCreate(IoUringDepth);
+        if (!run.Ring && verbose)
 #else
-                    child.path().string(),
+        if (verbose)
 #endif
-                    false});
-            }
-            continue;
+        {
+            std::cout << "io_uring is unavailable, using synchronous filesystem calls.\n";
         }
+    }
 
-        // Get all renameable path components (in bottom-up order)
-        auto components = AsciiRename::GetRenameableComponents(rawItem.Path);
+    if (!filter.Empty())
+    {
+        walkOptions.Filter = &filter;
+    }
 
-        for (size_t i = 0; i < components.size(); ++i)
+#ifdef ASCII_RENAME_SCAN_CACHE
+    std::unique_ptr<AsciiRename::ScanCache> cache;
+    if (!cachePath.empty())
+    {
+        cache = std::make_unique<AsciiRename::ScanCache>(cachePath, walkOptions.FollowSymlinks);
+        walkOptions.Cache = cache.get();
+        if (verbose)
         {
-            // Depth is inverse of position (first in list = deepest = highest depth value)
-            int depth = static_cast<int>(components.size() - i);
-            allOps.push_back({components[i], depth});
+            std::cout << "Loaded " << cache->Size() << " clean directories from the scan cache.\n";
         }
     }
-
-    // Sort by depth descending (deepest paths processed first)
-    std::sort(allOps.begin(), allOps.end());
-
-    // Remove duplicates (keep first occurrence of each source path)
-    auto last = std::unique(allOps.begin(), allOps.end());
-    allOps.erase(last, allOps.end());
-
-    if (verbose)
+#else
+    if (!cachePath.empty())
     {
-        std::cout << "Collected " << allOps.size() << " path components to process.\n";
+        std::cerr << "ERROR: --cache isn't supported on this platform.\n";
+        return -1;
     }
+#endif
 
-    // Process all rename operations with path tracking
-    PathTracker tracker;
-    int renames = 0;
-    int skipped = 0;
+    // Collect all rename operations from all path arguments
+    // This includes parent directories that need renaming
+    RenameOpSet allOps;
+    AsciiRename::DirectoryWalker walker(walkOptions);
 
-    for (auto &op : allOps)
+    // Serializes directories completed on different walker threads
+    std::mutex walkLock;
+
+    // Every argument is checked and queued before anything is walked, since a streamed
+    // walk renames as it goes and could rename a later argument out from under it
+    std::vector<WalkRoot> roots;
+    for (auto &rawPath : paths)
     {
-        // Resolve the current path (may have been affected by earlier renames)
-        auto currentPath = tracker.resolve(op.sourcePath);
+        AsciiRename::TrimTrailingPathSeparator(rawPath);
 
-        auto currentPathStr = std::string();
-        AsciiRename::TryGetUtf8(
-#ifdef _WIN32
-            currentPath.wstring(),
-#else
-            currentPath.string(),
-#endif
-            currentPathStr);
+        auto originalPath = std::filesystem::path(rawPath);
 
-        if (verbose)
-        {
-            std::cout << "Processing \"" << currentPathStr << "\"...\n";
-        }
+        // One stat answers both whether the path exists and whether it's a directory
+        std::error_code ec;
+        auto status = std::filesystem::status(originalPath, ec);
 
-        // Check if path still exists
-        if (!std::filesystem::exists(currentPath))
+        if (!std::filesystem::exists(status))
         {
-            if (verbose)
-            {
-                std::cout << "Path no longer exists, skipping \"" << currentPathStr << "\"...\n";
-            }
+            auto pathStr = std::string();
+            AsciiRename::TryGetUtf8(rawPath, pathStr);
+            std::cerr << "ERROR: \"" << pathStr << "\" doesn't exist.\n";
             continue;
         }
 
-        // Get ASCII + sanitized version of the filename only
-        auto filenameStr = std::string();
-        AsciiRename::TryGetUtf8(
-#ifdef _WIN32
-            currentPath.filename().wstring(),
-#else
-            currentPath.filename().string(),
-#endif
-            filenameStr);
+        AddRenameOps(run.Tree, allOps, originalPath);
 
-        auto asciiFilename = std::string();
-        if (!AsciiRename::TryGetAscii(filenameStr, asciiFilename))
+        if (recursive && std::filesystem::is_directory(status))
         {
-            std::cerr << "ERROR: Unable convert \"" << filenameStr << "\" to ASCII, skipping.\n";
-            ++skipped;
-            continue;
+            roots.push_back({originalPath, std::filesystem::canonical(originalPath, ec)});
         }
+    }
 
-        // Apply shell sanitization
-        asciiFilename = AsciiRename::SanitizeForShell(asciiFilename);
-
-        // Construct new path
-        auto newPath = currentPath.parent_path() / asciiFilename;
-
-        auto newPathStr = std::string();
-        AsciiRename::TryGetUtf8(
-#ifdef _WIN32
-            newPath.wstring(),
-#else
-            newPath.string(),
-#endif
-            newPathStr);
-
-        // Check if rename is needed
-        if (currentPathStr == newPathStr)
-        {
-            if (verbose)
-            {
-                std::cout << "No need to rename \"" << currentPathStr << "\".\n";
-            }
-            continue;
-        }
+    // First pass: expand recursive directories and collect all paths
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+        const auto &originalPath = roots[i].Path;
 
-        // Check for collision
-        if (std::filesystem::exists(newPath) && !overwrite)
+        // Expand recursive directories; the walker reports each entry's type, so
+        // nothing it finds needs to be stat'ed again here. Its ancestors are other
+        // entries or the root's components, so an entry only needs an op for its own
+        // name, and only if that name will change.
+        if (stream)
         {
-            // Special case: if source and dest are the same (case-insensitive match on some filesystems)
-            // we should still allow the rename
-            if (!std::filesystem::equivalent(currentPath, newPath))
+            // Streaming the enclosing argument renames this one's entries too, and
+            // would leave this walk looking for names that no longer exist
+            if (IsInsideOtherRoot(roots, i))
             {
-                std::cerr << "ERROR: \"" << newPathStr << "\" already exists.\n";
-                std::cerr << "ERROR: Specify --overwrite to overwrite.\n";
-                ++skipped;
                 continue;
             }
-        }
 
-        // Perform the rename
-        if (noop)
-        {
-            std::cout << "Would have renamed \"" << currentPathStr << "\" to \"" << newPathStr << "\"...\n";
-            ++renames;
-            // Record the rename for path resolution even in no-op mode
-            tracker.record(currentPath, newPath);
+            // A completed directory's subtree is renamed and none of its ancestors are yet,
+            // so its entries' paths are current and can be renamed straight away
+            std::vector<RenameOp> ops;
+            walker.Walk(originalPath, [&](const std::filesystem::path &directory,
+                                          std::vector<AsciiRename::WalkEntry> &entries) {
+                std::lock_guard<std::mutex> lock(walkLock);
+                ops.clear();
+                AddEntryRenameOps(run.Tree, ops, directory, entries);
+
+                // Path arguments inside the walk are renamed in the final pass, with
+                // the rest of their own components
+                ops.erase(std::remove_if(ops.begin(), ops.end(), [&](RenameOp op) { return allOps.Contains(op); }),
+                          ops.end());
+                ProcessOps(run, ops);
+                ReleaseEntryNodes(run, allOps, directory, entries);
+            });
         }
         else
         {
-            std::cout << "Renaming \"" << currentPathStr << "\" to \"" << newPathStr << "\"...\n";
-            try
-            {
-                std::filesystem::rename(currentPath, newPath);
-                ++renames;
-                // Record the rename for path resolution
-                tracker.record(currentPath, newPath);
-            }
-            catch (std::filesystem::filesystem_error &e)
-            {
-                std::cerr << "ERROR: File system error, unable to rename \"" << currentPathStr << "\" to \""
-                          << newPathStr << "\".\n";
-                ++skipped;
-            }
+            std::vector<RenameOp> ops;
+            walker.Walk(originalPath, [&](const std::filesystem::path &directory,
+                                          std::vector<AsciiRename::WalkEntry> &entries) {
+                std::lock_guard<std::mutex> lock(walkLock);
+                ops.clear();
+                AddEntryRenameOps(run.Tree, ops, directory, entries);
+                for (auto op : ops)
+                {
+                    allOps.Add(op);
+                }
+            });
         }
     }
 
+    // Deepest paths are processed first; duplicates were dropped as ops were added
+    auto sortedOps = allOps.TakeDeepestFirst(run.Tree);
+
+    if (verbose)
+    {
+        std::cout << "Collected " << sortedOps.size() << " path components to process.\n";
+    }
+
+    // Process all rename operations with path tracking. Without io_uring, independent
+    // directories can be renamed on several threads.
+#ifdef ASCII_RENAME_IO_URING
+    bool parallel = walkOptions.Jobs > 1 && !run.Ring;
+#else
+    bool parallel = walkOptions.Jobs > 1;
+#endif
+    if (parallel)
+    {
+        AsciiRename::RunInDependencyOrder(run.Tree, sortedOps, walkOptions.Jobs,
+                                          [&](RenameOp op) { ProcessOp(run, op); });
+    }
+    else
+    {
+        ProcessOps(run, sortedOps);
+    }
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+    // A no-op run renames nothing, so what it saw isn't what the next run will see
+    if (cache && !noop && !cache->Save())
+    {
+        auto cachePathStr = std::string();
+        AsciiRename::TryGetUtf8(cachePath, cachePathStr);
+        std::cerr << "ERROR: Unable to write scan cache \"" << cachePathStr << "\".\n";
+    }
+#endif
+
     if (verbose)
     {
-        std::cout << "Renamed: " << renames << ", Skipped: " << skipped << ", Total: " << renames + skipped << "\n";
+        std::cout << "Renamed: " << run.Renames << ", Skipped: " << run.Skipped
+                  << ", Total: " << run.Renames + run.Skipped << "\n";
+        std::cout << "Transliteration cache: " << run.Transliterations.Hits() << " hits, "
+                  << run.Transliterations.Misses() << " misses.\n";
+        auto codepointStats = AsciiRename::GetCodepointCacheStats();
+        std::cout << "Codepoint cache: " << codepointStats.Hits << " hits, " << codepointStats.Misses << " misses.\n";
     }
 
-    return skipped;
+    return run.Skipped;
 }
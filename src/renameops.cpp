@@ -0,0 +1,54 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include "renameops.h"
+
+namespace AsciiRename
+{
+
+void RenameOpSet::Add(RenameOp op)
+{
+    if (op >= queued_.size())
+    {
+        queued_.resize(std::max<size_t>(op + 1, queued_.size() * 2));
+    }
+    if (!queued_[op])
+    {
+        queued_[op] = true;
+        ops_.push_back(op);
+    }
+}
+
+std::vector<RenameOp> RenameOpSet::TakeDeepestFirst(ComponentTree const &tree)
+{
+    uint32_t maxDepth = 0;
+    for (auto op : ops_)
+    {
+        maxDepth = std::max(maxDepth, tree.Depth(op));
+    }
+
+    // Bucket d starts after every op deeper than d
+    std::vector<size_t> starts(maxDepth + 2, 0);
+    for (auto op : ops_)
+    {
+        ++starts[maxDepth - tree.Depth(op) + 1];
+    }
+    for (size_t i = 1; i < starts.size(); ++i)
+    {
+        starts[i] += starts[i - 1];
+    }
+
+    std::vector<RenameOp> sorted(ops_.size());
+    for (auto op : ops_)
+    {
+        sorted[starts[maxDepth - tree.Depth(op)]++] = op;
+    }
+
+    ops_.clear();
+    queued_.clear();
+    return sorted;
+}
+
+} // namespace AsciiRename
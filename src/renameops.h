@@ -0,0 +1,44 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef RENAMEOPS_H
+#define RENAMEOPS_H
+
+#include <vector>
+
+#include "componenttree.h"
+
+namespace AsciiRename
+{
+
+// A rename op is the node of the path to rename in the run's component tree
+using RenameOp = ComponentTree::NodeId;
+
+// The ops collected for a run, each queued at most once
+class RenameOpSet
+{
+    std::vector<RenameOp> ops_;
+    // Indexed by node; node ids are dense, so this stands in for a hash set
+    std::vector<bool> queued_;
+
+public:
+    size_t size() const
+    {
+        return ops_.size();
+    }
+
+    bool Contains(RenameOp op) const
+    {
+        return op < queued_.size() && queued_[op];
+    }
+
+    void Add(RenameOp op);
+
+    // Returns the ops deepest first, bucketed by depth with a counting sort. Ops at the
+    // same depth keep the order they were added in.
+    std::vector<RenameOp> TakeDeepestFirst(ComponentTree const &tree);
+};
+
+} // namespace AsciiRename
+
+#endif
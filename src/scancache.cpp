@@ -0,0 +1,277 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "scancache.h"
+
+namespace AsciiRename
+{
+
+// File layout: a Header, Count Records sorted by (Dev, Ino), then the names of the
+// records' subdirectories, each NUL-terminated
+struct ScanCacheHeader
+{
+    char Magic[8];
+    uint64_t Flags;
+    uint64_t Count;
+    uint64_t NamesSize;
+};
+
+static constexpr char ScanCacheMagic[8] = {'A', 'R', 'S', 'C', 'A', 'N', '2', '\0'};
+
+// Set in Flags if symlinked directories were listed as subdirectories
+static constexpr uint64_t FollowsSymlinks = 1;
+
+struct ScanCache::Record
+{
+    uint64_t Dev;
+    uint64_t Ino;
+    int64_t MtimeSec;
+    int64_t MtimeNsec;
+    int64_t CtimeSec;
+    int64_t CtimeNsec;
+    // Subdirectory names, at [NamesOffset, NamesOffset + NamesSize) of the names
+    uint64_t NamesOffset;
+    uint32_t NamesSize;
+    uint32_t SubdirectoryCount;
+
+    bool operator<(const Record &other) const
+    {
+        return Dev != other.Dev ? Dev < other.Dev : Ino < other.Ino;
+    }
+
+    bool SameDirectory(const Record &other) const
+    {
+        return Dev == other.Dev && Ino == other.Ino;
+    }
+
+    // Whether the directory is unchanged since this was recorded
+    bool Matches(const struct stat &st) const
+    {
+        return MtimeSec == st.st_mtim.tv_sec && MtimeNsec == st.st_mtim.tv_nsec && CtimeSec == st.st_ctim.tv_sec &&
+               CtimeNsec == st.st_ctim.tv_nsec;
+    }
+};
+
+ScanCache::ScanCache(std::filesystem::path path, bool followSymlinks)
+    : path_(std::move(path)), flags_(followSymlinks ? FollowsSymlinks : 0), startTime_(std::time(nullptr))
+{
+    Load();
+}
+
+ScanCache::~ScanCache()
+{
+    if (map_)
+    {
+        munmap(map_, mapSize_);
+    }
+}
+
+void ScanCache::Load()
+{
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ScanCacheHeader))
+    {
+        mapSize_ = static_cast<size_t>(st.st_size);
+        map_ = mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map_ == MAP_FAILED)
+        {
+            map_ = nullptr;
+        }
+    }
+    close(fd);
+
+    if (!map_)
+    {
+        return;
+    }
+
+    // Anything that doesn't add up is treated as no cache at all
+    auto header = static_cast<const ScanCacheHeader *>(map_);
+    size_t available = (mapSize_ - sizeof(ScanCacheHeader)) / sizeof(Record);
+    if (memcmp(header->Magic, ScanCacheMagic, sizeof(ScanCacheMagic)) != 0 || header->Flags != flags_ ||
+        header->Count > available ||
+        sizeof(ScanCacheHeader) + header->Count * sizeof(Record) + header->NamesSize != mapSize_)
+    {
+        return;
+    }
+
+    records_ = reinterpret_cast<const Record *>(static_cast<const char *>(map_) + sizeof(ScanCacheHeader));
+    recordCount_ = header->Count;
+    names_ = reinterpret_cast<const char *>(records_ + recordCount_);
+    namesSize_ = header->NamesSize;
+
+    stale_ = std::make_unique<std::atomic<bool>[]>(recordCount_);
+    for (size_t i = 0; i < recordCount_; ++i)
+    {
+        stale_[i] = false;
+    }
+}
+
+bool ScanCache::TryGetCleanSubdirectories(const struct stat &st, std::vector<std::string_view> &subdirectories)
+{
+    Record key{};
+    key.Dev = st.st_dev;
+    key.Ino = st.st_ino;
+
+    auto it = std::lower_bound(records_, records_ + recordCount_, key);
+    if (it == records_ + recordCount_ || !it->SameDirectory(key))
+    {
+        return false;
+    }
+    if (!it->Matches(st))
+    {
+        stale_[it - records_] = true;
+        return false;
+    }
+
+    if (it->NamesOffset > namesSize_ || it->NamesSize > namesSize_ - it->NamesOffset)
+    {
+        return false;
+    }
+
+    subdirectories.clear();
+    const char *p = names_ + it->NamesOffset;
+    const char *end = p + it->NamesSize;
+    while (p < end && subdirectories.size() < it->SubdirectoryCount)
+    {
+        size_t length = strnlen(p, static_cast<size_t>(end - p));
+        if (length == static_cast<size_t>(end - p))
+        {
+            return false;
+        }
+        subdirectories.emplace_back(p, length);
+        p += length + 1;
+    }
+    return subdirectories.size() == it->SubdirectoryCount;
+}
+
+void ScanCache::RecordClean(const struct stat &st, const std::vector<std::string_view> &subdirectories)
+{
+    if (st.st_mtim.tv_sec >= startTime_ || st.st_ctim.tv_sec >= startTime_)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+
+    Record record{};
+    record.Dev = st.st_dev;
+    record.Ino = st.st_ino;
+    record.MtimeSec = st.st_mtim.tv_sec;
+    record.MtimeNsec = st.st_mtim.tv_nsec;
+    record.CtimeSec = st.st_ctim.tv_sec;
+    record.CtimeNsec = st.st_ctim.tv_nsec;
+    record.NamesOffset = nextNames_.size();
+    record.SubdirectoryCount = static_cast<uint32_t>(subdirectories.size());
+    for (const auto &name : subdirectories)
+    {
+        nextNames_.append(name);
+        nextNames_.push_back('\0');
+    }
+    record.NamesSize = static_cast<uint32_t>(nextNames_.size() - record.NamesOffset);
+    nextRecords_.push_back(record);
+}
+
+bool ScanCache::Save()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    // The same directory can be reached more than once, e.g. through a symlink
+    std::sort(nextRecords_.begin(), nextRecords_.end());
+    auto last = std::unique(nextRecords_.begin(), nextRecords_.end(),
+                            [](const Record &a, const Record &b) { return a.SameDirectory(b); });
+    nextRecords_.erase(last, nextRecords_.end());
+
+    // Merge in the previous records this run didn't replace or find out of date. Both
+    // lists are sorted, so one pass keeps the result sorted.
+    std::vector<Record> records;
+    std::string names;
+    records.reserve(nextRecords_.size() + recordCount_);
+    names.reserve(nextNames_.size() + namesSize_);
+    auto append = [&](Record record, const char *recordNames) {
+        names.append(recordNames + record.NamesOffset, record.NamesSize);
+        record.NamesOffset = names.size() - record.NamesSize;
+        records.push_back(record);
+    };
+
+    size_t previous = 0;
+    for (const auto &record : nextRecords_)
+    {
+        for (; previous < recordCount_ && records_[previous] < record; ++previous)
+        {
+            if (!stale_[previous])
+            {
+                append(records_[previous], names_);
+            }
+        }
+        if (previous < recordCount_ && records_[previous].SameDirectory(record))
+        {
+            ++previous;
+        }
+        append(record, nextNames_.data());
+    }
+    for (; previous < recordCount_; ++previous)
+    {
+        if (!stale_[previous])
+        {
+            append(records_[previous], names_);
+        }
+    }
+
+    ScanCacheHeader header;
+    memcpy(header.Magic, ScanCacheMagic, sizeof(ScanCacheMagic));
+    header.Flags = flags_;
+    header.Count = records.size();
+    header.NamesSize = names.size();
+
+    // Write beside the old file and rename over it, so it's never seen half-written
+    auto tempPath = path_;
+    tempPath += ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto writeAll = [fd](const void *data, size_t size) {
+        auto p = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = write(fd, p, size);
+            if (written < 0)
+            {
+                return false;
+            }
+            p += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+
+    bool ok = writeAll(&header, sizeof(header)) &&
+              writeAll(records.data(), records.size() * sizeof(Record)) && writeAll(names.data(), names.size());
+    ok = close(fd) == 0 && ok;
+
+    if (!ok || rename(tempPath.c_str(), path_.c_str()) != 0)
+    {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace AsciiRename
@@ -0,0 +1,91 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef SCANCACHE_H
+#define SCANCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace AsciiRename
+{
+
+// A persistent record of directories found clean (every name already ASCII and
+// shell-safe) by earlier runs, keyed by device and inode. A directory whose mtime and
+// ctime haven't changed since still holds the same names, so it needn't be listed
+// again; only its subdirectories, kept with it, have to be visited. The ctime can't be
+// set back the way the mtime can, so a touched-back directory is still caught.
+//
+// The previous run's file is mmapped read-only; directories seen clean in this
+// run are collected separately and merged with the previous records by Save.
+//
+// Which subdirectories a record lists depends on whether symlinks were followed, so
+// a file written in the other mode is ignored and replaced.
+class ScanCache
+{
+    struct Record;
+
+    std::filesystem::path path_;
+    uint64_t flags_;
+    void *map_ = nullptr;
+    size_t mapSize_ = 0;
+    const Record *records_ = nullptr;
+    size_t recordCount_ = 0;
+    const char *names_ = nullptr;
+    size_t namesSize_ = 0;
+
+    // Per previous record: found out of date in this run, so not carried over
+    std::unique_ptr<std::atomic<bool>[]> stale_;
+
+    // Directories modified at or after this time aren't recorded, since a change
+    // within the same timestamp tick would go unnoticed next time
+    std::time_t startTime_;
+
+    std::mutex lock_;
+    std::vector<Record> nextRecords_;
+    std::string nextNames_;
+
+    void Load();
+
+public:
+    // Maps the cache at path for a walk that does or doesn't follow symlinks. A
+    // missing or invalid file, or one written in the other mode, gives an empty cache.
+    ScanCache(std::filesystem::path path, bool followSymlinks);
+    ~ScanCache();
+
+    ScanCache(const ScanCache &) = delete;
+    ScanCache &operator=(const ScanCache &) = delete;
+
+    // Number of directories loaded from the previous run
+    size_t Size() const
+    {
+        return recordCount_;
+    }
+
+    // If the directory was clean and is unchanged since the previous run, fills
+    // subdirectories with the names of its subdirectories and returns true. The
+    // names stay valid for the life of the cache. A record found out of date is
+    // dropped at the next Save.
+    bool TryGetCleanSubdirectories(const struct stat &st, std::vector<std::string_view> &subdirectories);
+
+    // Records a clean directory for the next run; safe to call from several threads
+    void RecordClean(const struct stat &st, const std::vector<std::string_view> &subdirectories);
+
+    // Replaces the cache file with the directories recorded in this run, plus the
+    // previous run's records that this run didn't find out of date (e.g. directories
+    // outside this run's roots, depth or filters)
+    bool Save();
+};
+
+} // namespace AsciiRename
+
+#endif
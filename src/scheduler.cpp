@@ -0,0 +1,152 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "scheduler.h"
+
+namespace AsciiRename
+{
+
+static constexpr size_t NoOp = static_cast<size_t>(-1);
+
+// The dependency DAG of one run. Each op waits on the ops whose nearest op ancestor
+// it is, which in turn waited on theirs, so it runs after everything below it.
+class DependencyScheduler
+{
+    // Ops on entries of one directory, which run one at a time in the order given
+    struct Group
+    {
+        bool Busy = false;
+        // Ops not started yet, in order
+        std::deque<size_t> Pending;
+    };
+
+    std::vector<ComponentTree::NodeId> const &ops_;
+    std::function<void(ComponentTree::NodeId)> const &runOp_;
+
+    // Per op: unfinished ops it waits on, the op waiting on it, and its directory's group
+    std::vector<size_t> waitingOn_;
+    std::vector<size_t> dependent_;
+    std::vector<size_t> group_;
+    std::vector<Group> groups_;
+
+    std::mutex lock_;
+    std::condition_variable changed_;
+    std::deque<size_t> ready_;
+    size_t remaining_;
+
+    // Queues the group's next op if none of its ops is running and the next one's
+    // dependencies are done. A later sibling that's ready still waits its turn.
+    void StartNext(Group &group)
+    {
+        if (!group.Busy && !group.Pending.empty() && waitingOn_[group.Pending.front()] == 0)
+        {
+            group.Busy = true;
+            ready_.push_back(group.Pending.front());
+            group.Pending.pop_front();
+        }
+    }
+
+    void Finish(size_t op)
+    {
+        auto &group = groups_[group_[op]];
+        group.Busy = false;
+        StartNext(group);
+
+        size_t dependent = dependent_[op];
+        if (dependent != NoOp && --waitingOn_[dependent] == 0)
+        {
+            StartNext(groups_[group_[dependent]]);
+        }
+
+        --remaining_;
+        changed_.notify_all();
+    }
+
+public:
+    DependencyScheduler(ComponentTree const &tree, std::vector<ComponentTree::NodeId> const &ops,
+                        std::function<void(ComponentTree::NodeId)> const &runOp)
+        : ops_(ops), runOp_(runOp), waitingOn_(ops.size(), 0), dependent_(ops.size(), NoOp),
+          group_(ops.size()), remaining_(ops.size())
+    {
+        std::vector<size_t> opOfNode(tree.Size(), NoOp);
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            opOfNode[ops[i]] = i;
+        }
+
+        std::unordered_map<ComponentTree::NodeId, size_t> groupOfDirectory;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            auto parent = tree.Parent(ops[i]);
+            auto inserted = groupOfDirectory.emplace(parent, groups_.size());
+            if (inserted.second)
+            {
+                groups_.emplace_back();
+            }
+            group_[i] = inserted.first->second;
+            groups_[group_[i]].Pending.push_back(i);
+
+            for (auto node = parent; node != ComponentTree::Root; node = tree.Parent(node))
+            {
+                if (opOfNode[node] != NoOp)
+                {
+                    dependent_[i] = opOfNode[node];
+                    ++waitingOn_[opOfNode[node]];
+                    break;
+                }
+            }
+        }
+
+        for (auto &group : groups_)
+        {
+            StartNext(group);
+        }
+    }
+
+    void Work()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        while (true)
+        {
+            changed_.wait(lock, [this] { return !ready_.empty() || remaining_ == 0; });
+            if (ready_.empty())
+            {
+                return;
+            }
+
+            size_t op = ready_.front();
+            ready_.pop_front();
+
+            lock.unlock();
+            runOp_(ops_[op]);
+            lock.lock();
+
+            Finish(op);
+        }
+    }
+};
+
+void RunInDependencyOrder(ComponentTree const &tree, std::vector<ComponentTree::NodeId> const &ops, unsigned jobs,
+                          std::function<void(ComponentTree::NodeId)> const &runOp)
+{
+    DependencyScheduler scheduler(tree, ops, runOp);
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs; ++i)
+    {
+        threads.emplace_back(&DependencyScheduler::Work, &scheduler);
+    }
+    scheduler.Work();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace AsciiRename
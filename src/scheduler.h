@@ -0,0 +1,26 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <functional>
+#include <vector>
+
+#include "componenttree.h"
+
+namespace AsciiRename
+{
+
+// Runs ops on a pool of threads in an order that respects the tree: an op doesn't
+// start until every op below it has finished, and ops on entries of the same
+// directory run one at a time and in the order given, so each sees its siblings'
+// renames when it checks for collisions and which of two colliding names is renamed
+// (or with --overwrite, which one wins) is the same as with one thread. Ops in
+// unrelated directories run in parallel.
+void RunInDependencyOrder(ComponentTree const &tree, std::vector<ComponentTree::NodeId> const &ops, unsigned jobs,
+                          std::function<void(ComponentTree::NodeId)> const &runOp);
+
+} // namespace AsciiRename
+
+#endif
@@ -0,0 +1,256 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "uring.h"
+
+namespace AsciiRename
+{
+
+// The mmapped submission and completion rings shared with the kernel
+struct IoUring::Rings
+{
+    int Fd = -1;
+
+    void *SqRing = MAP_FAILED;
+    size_t SqRingSize = 0;
+    void *CqRing = MAP_FAILED;
+    size_t CqRingSize = 0;
+    io_uring_sqe *Sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t SqesSize = 0;
+
+    unsigned *SqHead = nullptr;
+    unsigned *SqTail = nullptr;
+    unsigned *SqMask = nullptr;
+    unsigned *SqArray = nullptr;
+    unsigned *CqHead = nullptr;
+    unsigned *CqTail = nullptr;
+    unsigned *CqMask = nullptr;
+    io_uring_cqe *Cqes = nullptr;
+
+    // Claims the submission slot queued entries past the tail and resets it
+    io_uring_sqe *NextSqe(unsigned queued, uint64_t userData)
+    {
+        unsigned index = (*SqTail + queued) & *SqMask;
+        io_uring_sqe *sqe = &Sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = userData;
+        SqArray[index] = index;
+        return sqe;
+    }
+
+    // Reports every completion posted so far and returns how many there were
+    unsigned Reap(const std::function<void(uint64_t userData, int result)> &onComplete)
+    {
+        unsigned head = *CqHead;
+        unsigned tail = __atomic_load_n(CqTail, __ATOMIC_ACQUIRE);
+        unsigned count = tail - head;
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe &cqe = Cqes[head & *CqMask];
+            onComplete(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(CqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    ~Rings()
+    {
+        if (Sqes != MAP_FAILED)
+        {
+            munmap(Sqes, SqesSize);
+        }
+        if (CqRing != MAP_FAILED && CqRing != SqRing)
+        {
+            munmap(CqRing, CqRingSize);
+        }
+        if (SqRing != MAP_FAILED)
+        {
+            munmap(SqRing, SqRingSize);
+        }
+        if (Fd >= 0)
+        {
+            close(Fd);
+        }
+    }
+};
+
+template <typename T> static T *RingField(void *ring, uint32_t offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+static bool SupportsOps(int fd, std::initializer_list<int> ops)
+{
+    std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+    {
+        return false;
+    }
+
+    for (int op : ops)
+    {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+IoUring::IoUring() : rings_(std::make_unique<Rings>())
+{
+}
+
+IoUring::~IoUring() = default;
+
+std::unique_ptr<IoUring> IoUring::TryCreate(unsigned depth)
+{
+    std::unique_ptr<IoUring> ring(new IoUring());
+    Rings &r = *ring->rings_;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    r.Fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+    if (r.Fd < 0 || !SupportsOps(r.Fd, {IORING_OP_STATX, IORING_OP_RENAMEAT}))
+    {
+        return nullptr;
+    }
+
+    r.SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    r.CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        r.SqRingSize = r.CqRingSize = std::max(r.SqRingSize, r.CqRingSize);
+    }
+
+    r.SqRing = mmap(nullptr, r.SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r.Fd,
+                    IORING_OFF_SQ_RING);
+    if (r.SqRing == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        r.CqRing = r.SqRing;
+    }
+    else
+    {
+        r.CqRing = mmap(nullptr, r.CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r.Fd,
+                        IORING_OFF_CQ_RING);
+        if (r.CqRing == MAP_FAILED)
+        {
+            return nullptr;
+        }
+    }
+
+    r.SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    r.Sqes = static_cast<io_uring_sqe *>(
+        mmap(nullptr, r.SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r.Fd, IORING_OFF_SQES));
+    if (r.Sqes == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    r.SqHead = RingField<unsigned>(r.SqRing, params.sq_off.head);
+    r.SqTail = RingField<unsigned>(r.SqRing, params.sq_off.tail);
+    r.SqMask = RingField<unsigned>(r.SqRing, params.sq_off.ring_mask);
+    r.SqArray = RingField<unsigned>(r.SqRing, params.sq_off.array);
+    r.CqHead = RingField<unsigned>(r.CqRing, params.cq_off.head);
+    r.CqTail = RingField<unsigned>(r.CqRing, params.cq_off.tail);
+    r.CqMask = RingField<unsigned>(r.CqRing, params.cq_off.ring_mask);
+    r.Cqes = RingField<io_uring_cqe>(r.CqRing, params.cq_off.cqes);
+
+    ring->depth_ = params.sq_entries;
+    return ring;
+}
+
+void IoUring::QueueStatx(int dirFd, const char *path, int flags, unsigned mask, struct statx *result,
+                         uint64_t userData)
+{
+    io_uring_sqe *sqe = rings_->NextSqe(queued_++, userData);
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = dirFd;
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->len = mask;
+    sqe->off = reinterpret_cast<uint64_t>(result);
+    sqe->statx_flags = static_cast<uint32_t>(flags);
+}
+
+void IoUring::QueueRenameat(int fromDirFd, const char *from, int toDirFd, const char *to, unsigned flags,
+                            uint64_t userData)
+{
+    io_uring_sqe *sqe = rings_->NextSqe(queued_++, userData);
+    sqe->opcode = IORING_OP_RENAMEAT;
+    sqe->fd = fromDirFd;
+    sqe->addr = reinterpret_cast<uint64_t>(from);
+    sqe->len = static_cast<uint32_t>(toDirFd);
+    sqe->off = reinterpret_cast<uint64_t>(to);
+    sqe->rename_flags = flags;
+}
+
+bool IoUring::SubmitAndWait(const std::function<void(uint64_t userData, int result)> &onComplete)
+{
+    Rings &r = *rings_;
+    unsigned toSubmit = queued_;
+    queued_ = 0;
+    if (toSubmit == 0 || failed_)
+    {
+        return !failed_;
+    }
+
+    // Publish the new entries to the kernel
+    unsigned start = *r.SqTail;
+    __atomic_store_n(r.SqTail, start + toSubmit, __ATOMIC_RELEASE);
+
+    unsigned completed = 0;
+    unsigned submitted = 0;
+    while (completed < toSubmit)
+    {
+        long ret = syscall(__NR_io_uring_enter, r.Fd, toSubmit - submitted, toSubmit - completed,
+                           IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            {
+                continue;
+            }
+            failed_ = true;
+            break;
+        }
+        submitted += static_cast<unsigned>(ret);
+        completed += r.Reap(onComplete);
+    }
+
+    if (!failed_)
+    {
+        return true;
+    }
+
+    // Withdraw the entries the kernel never took. Those it did take point into the
+    // caller's buffers, so wait until each has completed before returning; the
+    // completion queue is shared memory, so it can be watched without entering the
+    // ring, and sleeping lets any pending completion work run.
+    unsigned consumed = __atomic_load_n(r.SqHead, __ATOMIC_ACQUIRE) - start;
+    __atomic_store_n(r.SqTail, start + consumed, __ATOMIC_RELEASE);
+    while ((completed += r.Reap(onComplete)) < consumed)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return false;
+}
+
+} // namespace AsciiRename
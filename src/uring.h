@@ -0,0 +1,66 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef URING_H
+#define URING_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <sys/stat.h>
+
+namespace AsciiRename
+{
+
+// A minimal io_uring instance (Linux 5.11+) for submitting batches of statx and
+// renameat calls, driven through the raw syscalls so there's no liburing dependency
+class IoUring
+{
+    struct Rings;
+    std::unique_ptr<Rings> rings_;
+    unsigned depth_ = 0;
+    unsigned queued_ = 0;
+    bool failed_ = false;
+
+    IoUring();
+
+public:
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // Returns null if io_uring, or its statx or renameat ops, aren't available
+    static std::unique_ptr<IoUring> TryCreate(unsigned depth);
+
+    // Maximum number of calls that can be queued between submissions
+    unsigned Depth() const
+    {
+        return depth_;
+    }
+
+    // Queue statx(dirFd, path, flags, mask, result). The strings and result must stay
+    // valid until the batch completes.
+    void QueueStatx(int dirFd, const char *path, int flags, unsigned mask, struct statx *result, uint64_t userData);
+
+    // Queue renameat2(fromDirFd, from, toDirFd, to, flags)
+    void QueueRenameat(int fromDirFd, const char *from, int toDirFd, const char *to, unsigned flags,
+                       uint64_t userData);
+
+    // Submit everything queued, wait for all of it to complete and call onComplete
+    // with each call's user data and result (0 or a negated errno). Returns false if
+    // the ring itself fails. Every call the kernel took has still completed and been
+    // reported by then; the rest were withdrawn and are never reported.
+    bool SubmitAndWait(const std::function<void(uint64_t userData, int result)> &onComplete);
+
+    // Whether a submission has failed; a failed ring can't be used again
+    bool Failed() const
+    {
+        return failed_;
+    }
+};
+
+} // namespace AsciiRename
+
+#endif
@@ -0,0 +1,577 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "filter.h"
+#include "helpers.h"
+#include "walker.h"
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+#include "scancache.h"
+#endif
+
+namespace AsciiRename
+{
+
+#ifdef __linux__
+// An open directory file descriptor, shared by the queued work for its subdirectories
+// so they can be opened relative to it. Closed once the last of them has been opened.
+class DirectoryHandle
+{
+    int fd_;
+
+public:
+    explicit DirectoryHandle(int fd) : fd_(fd)
+    {
+    }
+
+    ~DirectoryHandle()
+    {
+        close(fd_);
+    }
+
+    DirectoryHandle(const DirectoryHandle &) = delete;
+    DirectoryHandle &operator=(const DirectoryHandle &) = delete;
+
+    int Fd() const
+    {
+        return fd_;
+    }
+};
+
+// Record layout returned by getdents64
+struct LinuxDirent64
+{
+    uint64_t Ino;
+    int64_t Off;
+    unsigned short Reclen;
+    unsigned char Type;
+    char Name[1];
+};
+
+// Large enough to read most directories in one getdents64 call
+static constexpr size_t DirentBufferSize = 64 * 1024;
+
+// Whether a directory entry is (or, for followed symlinks, points to) a directory. The
+// type from getdents64 answers this without a syscall; only entries the filesystem
+// didn't type and symlinks being followed need a stat.
+static bool IsDirectoryEntry(int parentFd, const char *name, unsigned char type, bool followSymlinks)
+{
+    if (type != DT_UNKNOWN && (type != DT_LNK || !followSymlinks))
+    {
+        return type == DT_DIR;
+    }
+
+    int flags = followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+#ifdef STATX_TYPE
+    struct statx stx;
+    return statx(parentFd, name, flags, STATX_TYPE, &stx) == 0 && S_ISDIR(stx.stx_mode);
+#else
+    struct stat st;
+    return fstatat(parentFd, name, &st, flags) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+// Identifies a directory by device and inode
+struct FileId
+{
+    uint64_t Dev;
+    uint64_t Ino;
+
+    bool operator==(const FileId &other) const
+    {
+        return Dev == other.Dev && Ino == other.Ino;
+    }
+};
+
+struct FileIdHash
+{
+    size_t operator()(const FileId &id) const
+    {
+        return static_cast<size_t>((id.Ino * 0x9E3779B97F4A7C15ull) ^ id.Dev);
+    }
+};
+
+using VisitedKey = FileId;
+using VisitedKeyHash = FileIdHash;
+#else
+// Without inodes to go by, directories are told apart by their canonical paths
+using VisitedKey = std::filesystem::path::string_type;
+using VisitedKeyHash = std::hash<VisitedKey>;
+#endif
+
+// Directories already listed in this walk, so one reached again through a symlink or a
+// bind mount isn't listed twice and a symlink cycle can't be walked forever. Sharded so
+// workers rarely wait on each other.
+class VisitedSet
+{
+    static constexpr size_t ShardCount = 16;
+
+    struct Shard
+    {
+        std::mutex Lock;
+        std::unordered_set<VisitedKey, VisitedKeyHash> Keys;
+    };
+
+    Shard shards_[ShardCount];
+
+public:
+    // Returns false if the directory was already visited
+    bool Insert(VisitedKey const &key)
+    {
+        auto &shard = shards_[(VisitedKeyHash()(key) >> 8) % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.Lock);
+        return shard.Keys.insert(key).second;
+    }
+};
+
+// A directory in the walk. Holds its entries, and keeps its parent alive, until its
+// whole subtree has been scanned.
+struct DirectoryNode
+{
+    std::filesystem::path Path;
+    std::shared_ptr<DirectoryNode> Parent;
+    std::vector<WalkEntry> Entries;
+    // Levels below the root, which is at depth 0
+    unsigned Depth;
+
+    // Its own scan plus each subdirectory whose subtree isn't complete yet
+    std::atomic<size_t> Remaining{1};
+
+    DirectoryNode(std::filesystem::path path, std::shared_ptr<DirectoryNode> parent)
+        : Path(std::move(path)), Parent(std::move(parent)), Depth(Parent ? Parent->Depth + 1 : 0)
+    {
+    }
+};
+
+// A directory waiting to be scanned
+struct DirectoryWork
+{
+    std::shared_ptr<DirectoryNode> Node;
+#ifdef __linux__
+    // The open directory containing Node, or null for the root of the walk
+    std::shared_ptr<DirectoryHandle> ParentHandle = nullptr;
+#endif
+};
+
+// Shared state of one walk: a work-stealing deque per worker
+class WalkState
+{
+    struct Worker
+    {
+        std::mutex Lock;
+        std::deque<DirectoryWork> Directories;
+#ifdef __linux__
+        std::vector<char> DirentBuffer;
+#endif
+#ifdef ASCII_RENAME_SCAN_CACHE
+        std::vector<std::string_view> Subdirectories;
+#endif
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    WalkOptions const &options_;
+    DirectoryWalker::DirectoryDone const &onDirectoryDone_;
+    VisitedSet visited_;
+#ifdef __linux__
+    // Set by the root's scan, before any other directory is queued
+    dev_t rootDev_ = 0;
+#endif
+
+    // Directories queued or being scanned; the walk is over when this reaches zero
+    std::atomic<size_t> pending_{0};
+
+    // Directories sitting in a deque, waiting for a worker
+    std::atomic<size_t> queued_{0};
+
+    // Workers with nothing to do sleep here until a directory is queued or the walk ends
+    std::mutex idleLock_;
+    std::condition_variable idle_;
+    std::atomic<size_t> sleepers_{0};
+
+    // Wakes sleeping workers. Callers change queued_ or pending_ first; a worker about to
+    // sleep counts itself in sleepers_ before checking them, so one side always sees
+    // the other.
+    void Wake(bool all)
+    {
+        if (sleepers_ > 0)
+        {
+            std::lock_guard<std::mutex> lock(idleLock_);
+            if (all)
+            {
+                idle_.notify_all();
+            }
+            else
+            {
+                idle_.notify_one();
+            }
+        }
+    }
+
+    void Sleep()
+    {
+        std::unique_lock<std::mutex> lock(idleLock_);
+        ++sleepers_;
+        idle_.wait(lock, [this] { return queued_ > 0 || pending_ == 0; });
+        --sleepers_;
+    }
+
+    void Push(size_t self, DirectoryWork work)
+    {
+        ++pending_;
+        {
+            std::lock_guard<std::mutex> lock(workers_[self]->Lock);
+            workers_[self]->Directories.push_back(std::move(work));
+            ++queued_;
+        }
+        Wake(false);
+    }
+
+    bool TryPop(size_t self, DirectoryWork &work)
+    {
+        std::lock_guard<std::mutex> lock(workers_[self]->Lock);
+        if (workers_[self]->Directories.empty())
+        {
+            return false;
+        }
+        work = std::move(workers_[self]->Directories.back());
+        workers_[self]->Directories.pop_back();
+        --queued_;
+        return true;
+    }
+
+    bool TrySteal(size_t self, DirectoryWork &work)
+    {
+        for (size_t i = 1; i < workers_.size(); ++i)
+        {
+            auto &victim = *workers_[(self + i) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.Lock);
+            if (!victim.Directories.empty())
+            {
+                work = std::move(victim.Directories.front());
+                victim.Directories.pop_front();
+                --queued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void ReportScanError(std::filesystem::path const &directory)
+    {
+        auto pathStr = std::string();
+        TryGetUtf8(directory.native(), pathStr);
+        std::cerr << "ERROR: Unable to scan \"" + pathStr + "\", skipping.\n";
+    }
+
+    // Whether the subdirectories of node are within the depth limit
+    bool CanDescend(DirectoryNode const &node) const
+    {
+        return options_.MaxDepth == 0 || node.Depth + 1 < options_.MaxDepth;
+    }
+
+    // Queue a subdirectory found while scanning node
+    void AddSubdirectory(size_t self, std::shared_ptr<DirectoryNode> const &node, DirectoryWork work)
+    {
+        ++node->Remaining;
+        Push(self, std::move(work));
+    }
+
+    // Called when a scan or a subtree below node finishes. Completes node, and then
+    // any ancestors, once nothing below them is outstanding.
+    void Release(std::shared_ptr<DirectoryNode> node)
+    {
+        while (node && --node->Remaining == 0)
+        {
+            onDirectoryDone_(node->Path, node->Entries);
+            node->Entries = std::vector<WalkEntry>();
+            node = std::move(node->Parent);
+        }
+    }
+
+#ifdef __linux__
+    // Opens the directory relative to its parent's descriptor, so the kernel resolves
+    // one component instead of the whole path, and lists it with getdents64
+    void Scan(size_t self, DirectoryWork &work)
+    {
+        auto &node = work.Node;
+
+        // When not following, a subdirectory that turns out to be a symlink (e.g. one
+        // replaced by a symlink since it was listed) fails to open with ELOOP and is
+        // quietly passed over
+        int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (options_.FollowSymlinks ? 0 : O_NOFOLLOW);
+        int fd = work.ParentHandle ? openat(work.ParentHandle->Fd(), node->Path.filename().c_str(), flags)
+                                   : open(node->Path.c_str(), flags & ~O_NOFOLLOW);
+
+        // The parent is no longer needed by this directory
+        work.ParentHandle.reset();
+
+        if (fd < 0)
+        {
+            if (errno != ELOOP || options_.FollowSymlinks)
+            {
+                ReportScanError(node->Path);
+            }
+            return;
+        }
+
+        auto handle = std::make_shared<DirectoryHandle>(fd);
+        auto &worker = *workers_[self];
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ReportScanError(node->Path);
+            return;
+        }
+
+        // A mount point below the root is listed in its parent but not entered
+        if (!node->Parent)
+        {
+            rootDev_ = st.st_dev;
+        }
+        else if (options_.OneFileSystem && st.st_dev != rootDev_)
+        {
+            return;
+        }
+
+        if (!visited_.Insert({static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino)}))
+        {
+            return;
+        }
+
+        bool descend = CanDescend(*node);
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+        auto cache = options_.Cache;
+        if (cache && cache->TryGetCleanSubdirectories(st, worker.Subdirectories))
+        {
+            for (auto name : worker.Subdirectories)
+            {
+                if (options_.Filter && options_.Filter->Prunes(name))
+                {
+                    continue;
+                }
+
+                auto path = node->Path / name;
+                node->Entries.push_back({path, true, false});
+                if (descend)
+                {
+                    AddSubdirectory(self, node, {std::make_shared<DirectoryNode>(std::move(path), node), handle});
+                }
+            }
+            cache->RecordClean(st, worker.Subdirectories);
+            return;
+        }
+#endif
+
+        worker.DirentBuffer.resize(DirentBufferSize);
+
+        // A directory with entries left out can't be recorded as clean
+        [[maybe_unused]] bool filtered = false;
+
+        while (true)
+        {
+            long bytes = syscall(SYS_getdents64, fd, worker.DirentBuffer.data(), worker.DirentBuffer.size());
+            if (bytes < 0)
+            {
+                ReportScanError(node->Path);
+                return;
+            }
+            if (bytes == 0)
+            {
+                break;
+            }
+
+            for (long offset = 0; offset < bytes;)
+            {
+                const char *record = worker.DirentBuffer.data() + offset;
+                const auto *dirent = reinterpret_cast<const LinuxDirent64 *>(record);
+                const char *name = record + offsetof(LinuxDirent64, Name);
+                offset += dirent->Reclen;
+
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                {
+                    continue;
+                }
+
+                if (options_.Filter && options_.Filter->Prunes(name))
+                {
+                    filtered = true;
+                    continue;
+                }
+
+                bool isDirectory = IsDirectoryEntry(fd, name, dirent->Type, options_.FollowSymlinks);
+                if (!isDirectory && options_.Filter && options_.Filter->SkipsFile(name))
+                {
+                    filtered = true;
+                    continue;
+                }
+
+                auto path = node->Path / name;
+                node->Entries.push_back({path, isDirectory, NeedsRename(name)});
+                if (isDirectory && descend)
+                {
+                    AddSubdirectory(self, node, {std::make_shared<DirectoryNode>(std::move(path), node), handle});
+                }
+            }
+        }
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+        if (cache && !filtered)
+        {
+            RecordIfClean(worker, *node, st);
+        }
+#endif
+    }
+
+#ifdef ASCII_RENAME_SCAN_CACHE
+    // Records a fully listed directory in the cache if none of its names need renaming
+    void RecordIfClean(Worker &worker, DirectoryNode const &node, struct stat const &st)
+    {
+        worker.Subdirectories.clear();
+        for (auto const &entry : node.Entries)
+        {
+            if (entry.NeedsRename)
+            {
+                return;
+            }
+            if (entry.IsDirectory)
+            {
+                std::string_view path = entry.Path.native();
+                worker.Subdirectories.push_back(path.substr(path.rfind('/') + 1));
+            }
+        }
+        options_.Cache->RecordClean(st, worker.Subdirectories);
+    }
+#endif
+#else
+    void Scan(size_t self, DirectoryWork &work)
+    {
+        auto &node = work.Node;
+        std::error_code ec;
+
+        auto canonicalPath = std::filesystem::canonical(node->Path, ec);
+        if (!ec && !visited_.Insert(canonicalPath.native()))
+        {
+            return;
+        }
+
+        bool descend = CanDescend(*node);
+        auto it = std::filesystem::directory_iterator(node->Path, ec);
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+        {
+            auto name = std::string();
+            bool needsRename = !TryGetUtf8(it->path().filename().native(), name) || NeedsRename(name);
+            if (options_.Filter && options_.Filter->Prunes(name))
+            {
+                continue;
+            }
+
+            auto type = options_.FollowSymlinks ? it->status(ec).type() : it->symlink_status(ec).type();
+            bool isDirectory = type == std::filesystem::file_type::directory;
+            ec.clear();
+            if (!isDirectory && options_.Filter && options_.Filter->SkipsFile(name))
+            {
+                continue;
+            }
+
+            node->Entries.push_back({it->path(), isDirectory, needsRename});
+            if (isDirectory && descend)
+            {
+                AddSubdirectory(self, node, {std::make_shared<DirectoryNode>(it->path(), node)});
+            }
+        }
+
+        if (ec)
+        {
+            ReportScanError(node->Path);
+        }
+    }
+#endif
+
+public:
+    WalkState(WalkOptions const &options, DirectoryWalker::DirectoryDone const &onDirectoryDone)
+        : options_(options), onDirectoryDone_(onDirectoryDone)
+    {
+        for (unsigned i = 0; i < options.Jobs; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+    }
+
+    void Start(std::filesystem::path const &root)
+    {
+        Push(0, {std::make_shared<DirectoryNode>(root, nullptr)});
+    }
+
+    void Work(size_t self)
+    {
+        DirectoryWork work;
+        while (pending_ > 0)
+        {
+            if (TryPop(self, work) || TrySteal(self, work))
+            {
+                Scan(self, work);
+                Release(std::move(work.Node));
+                work = DirectoryWork();
+                if (--pending_ == 0)
+                {
+                    Wake(true);
+                }
+            }
+            else
+            {
+                Sleep();
+            }
+        }
+    }
+};
+
+DirectoryWalker::DirectoryWalker(WalkOptions const &options) : options_(options)
+{
+    if (options_.Jobs == 0)
+    {
+        options_.Jobs = 1;
+    }
+}
+
+void DirectoryWalker::Walk(std::filesystem::path const &root, DirectoryDone const &onDirectoryDone)
+{
+    WalkState state(options_, onDirectoryDone);
+    state.Start(root);
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < options_.Jobs; ++i)
+    {
+        threads.emplace_back(&WalkState::Work, &state, i);
+    }
+    state.Work(0);
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace AsciiRename
@@ -0,0 +1,72 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef WALKER_H
+#define WALKER_H
+
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace AsciiRename
+{
+
+class ScanCache;
+struct NameFilter;
+
+// An entry found below the root of a walk
+struct WalkEntry
+{
+    std::filesystem::path Path;
+    bool IsDirectory;
+    // Whether the entry's own name would change when renamed
+    bool NeedsRename;
+};
+
+struct WalkOptions
+{
+    // Number of threads scanning directories
+    unsigned Jobs = 1;
+
+    // Whether to descend into symlinks to directories. Either way each directory is
+    // listed at most once per walk, so symlink cycles end.
+    bool FollowSymlinks = true;
+
+    // Don't descend into directories on other devices than the root's (Linux)
+    bool OneFileSystem = false;
+
+    // If nonzero, entries more than this many levels below the root aren't listed
+    unsigned MaxDepth = 0;
+
+    // If set, entries it rejects aren't listed, and rejected directories aren't opened
+    NameFilter const *Filter = nullptr;
+
+    // If set (Linux only), directories it knows to be clean and unchanged aren't
+    // listed: only their subdirectories are reported and walked
+    ScanCache *Cache = nullptr;
+};
+
+// Lists a directory tree recursively on a pool of worker threads. Each worker owns a
+// deque of directories still to scan: it takes its newest directory from the back
+// and, once it runs dry, steals the oldest directory from the front of another's.
+class DirectoryWalker
+{
+    WalkOptions options_;
+
+public:
+    // Called with a directory and its entries once everything below it has been
+    // scanned. May be called on several worker threads at once, and must not throw.
+    using DirectoryDone = std::function<void(std::filesystem::path const &directory, std::vector<WalkEntry> &entries)>;
+
+    explicit DirectoryWalker(WalkOptions const &options);
+
+    // Walks every directory below root. Directories are handed to onDirectoryDone in
+    // post-order, each as soon as its own subtree is complete, while other subtrees
+    // are still being scanned. Directories that can't be scanned are reported to
+    // stderr and skipped.
+    void Walk(std::filesystem::path const &root, DirectoryDone const &onDirectoryDone);
+};
+
+} // namespace AsciiRename
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <cstdint>
+#include <string>
+
+#include <anyascii.h>
+
+#include "check.h"
+
+static std::string Transliterate(uint32_t codepoint)
+{
+    const char *ascii;
+    size_t length = anyascii(codepoint, &ascii);
+    return std::string(ascii, length);
+}
+
+// Spot checks across the blocks the table indexes, including empty ones
+static void TestKnownCodepoints()
+{
+    CHECK_EQUAL(Transliterate('a'), "a");
+    CHECK_EQUAL(Transliterate(0xE9), "e");
+    CHECK_EQUAL(Transliterate(0xDF), "ss");
+    CHECK_EQUAL(Transliterate(0x300), "");
+    CHECK_EQUAL(Transliterate(0x416), "Zh");
+    CHECK_EQUAL(Transliterate(0x2460), "1");
+    CHECK_EQUAL(Transliterate(0x2603), "%snowman2%");
+    CHECK_EQUAL(Transliterate(0x30A2), "a");
+    CHECK_EQUAL(Transliterate(0x97F3), "Yin");
+    CHECK_EQUAL(Transliterate(0xAC00), "Ga");
+    CHECK_EQUAL(Transliterate(0xFFFD), "?");
+    CHECK_EQUAL(Transliterate(0x1D400), "A");
+    CHECK_EQUAL(Transliterate(0x1F600), "%grinning%");
+    CHECK_EQUAL(Transliterate(0xE0041), "A");
+    CHECK_EQUAL(Transliterate(0x10FFFF), "");
+    CHECK_EQUAL(Transliterate(0x110000), "");
+    CHECK_EQUAL(Transliterate(0xFFFFFFFF), "");
+}
+
+// Every codepoint's result, hashed. The expected values come from the upstream
+// switch-based block() that the page index replaced, so any table entry pointing at
+// the wrong block shows up here.
+static void TestEveryCodepoint()
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t total = 0;
+    for (uint32_t codepoint = 0; codepoint <= 0x10FFFF; ++codepoint)
+    {
+        const char *ascii;
+        size_t length = anyascii(codepoint, &ascii);
+        total += length;
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(ascii[i])) * 0x100000001b3ull;
+        }
+
+        // Separates results, so moving a char from one to the next changes the hash
+        hash = (hash ^ 0xFF) * 0x100000001b3ull;
+    }
+
+    CHECK_EQUAL(total, 298481u);
+    CHECK_EQUAL(hash, 0xcd615782231b46ceull);
+}
+
+int main()
+{
+    TestKnownCodepoints();
+    TestEveryCodepoint();
+    return CheckResult();
+}
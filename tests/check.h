@@ -0,0 +1,47 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// Minimal assertions for the unit tests, so they need nothing beyond the compiler.
+// A failed check is reported and counted, and the test keeps going.
+inline int CheckFailures = 0;
+
+#define CHECK(expr)                                                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(expr))                                                                                                   \
+        {                                                                                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #expr "\n";                                 \
+            ++CheckFailures;                                                                                           \
+        }                                                                                                              \
+    } while (false)
+
+#define CHECK_EQUAL(actual, expected)                                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        auto const &checkActual = (actual);                                                                            \
+        auto const &checkExpected = (expected);                                                                        \
+        if (!(checkActual == checkExpected))                                                                           \
+        {                                                                                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQUAL failed: " #actual " is \"" << checkActual      \
+                      << "\", expected \"" << checkExpected << "\"\n";                                                \
+            ++CheckFailures;                                                                                           \
+        }                                                                                                              \
+    } while (false)
+
+// Returns the process exit code for the checks run so far
+inline int CheckResult()
+{
+    if (CheckFailures != 0)
+    {
+        std::cerr << CheckFailures << " check(s) failed.\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "componenttree.h"
+
+using namespace AsciiRename;
+
+static ComponentTree::String Native(const char *name)
+{
+    return std::filesystem::path(name).native();
+}
+
+static std::string NameOf(ComponentTree const &tree, ComponentTree::NodeId node)
+{
+    return std::filesystem::path(ComponentTree::String(tree.Name(node))).string();
+}
+
+static void TestIntern()
+{
+    ComponentTree tree;
+    auto ab = tree.Intern("a/b");
+    auto a = tree.Parent(ab);
+    CHECK(ab != ComponentTree::Root);
+    CHECK(a != ComponentTree::Root);
+    CHECK_EQUAL(tree.Parent(a), ComponentTree::Root);
+
+    // Shared prefixes are interned once
+    CHECK_EQUAL(tree.Intern("a/b"), ab);
+    CHECK_EQUAL(tree.Intern("a"), a);
+    CHECK_EQUAL(tree.Parent(tree.Intern("a/c")), a);
+    CHECK(tree.Intern("b/b") != ab);
+
+    CHECK_EQUAL(tree.Depth(a), 1u);
+    CHECK_EQUAL(tree.Depth(ab), 2u);
+    CHECK_EQUAL(NameOf(tree, ab), "b");
+    CHECK_EQUAL(tree.Path(ab), std::filesystem::path("a/b"));
+
+    CHECK_EQUAL(tree.Find(a, Native("b")), ab);
+    CHECK_EQUAL(tree.Find(a, Native("missing")), ComponentTree::Root);
+    CHECK_EQUAL(tree.Find(ComponentTree::Root, Native("c")), ComponentTree::Root);
+}
+
+static void TestUnrenameableComponents()
+{
+    ComponentTree tree;
+    auto x = tree.Intern("./x");
+    CHECK_EQUAL(tree.Depth(x), 1u);
+    CHECK(tree.IsRenameable(x));
+    CHECK(!tree.IsRenameable(tree.Parent(x)));
+    CHECK(!tree.IsRenameable(ComponentTree::Root));
+    CHECK_EQUAL(tree.Path(x), std::filesystem::path("./x"));
+}
+
+static void TestRename()
+{
+    ComponentTree tree;
+    auto abc = tree.Intern("a/b/c");
+    auto ab = tree.Parent(abc);
+    auto a = tree.Parent(ab);
+
+    // A rename shows up in the paths of everything below it
+    tree.Rename(a, Native("x"));
+    CHECK_EQUAL(NameOf(tree, a), "x");
+    CHECK_EQUAL(tree.Path(abc), std::filesystem::path("x/b/c"));
+    tree.Rename(abc, Native("longer name"));
+    CHECK_EQUAL(tree.Path(abc), std::filesystem::path("x/b/longer name"));
+    tree.Rename(a, Native("y"));
+    CHECK_EQUAL(tree.Path(abc), std::filesystem::path("y/b/longer name"));
+
+    // Nodes are still found by their original names, as the walk reported them
+    CHECK_EQUAL(tree.Intern("a/b/c"), abc);
+    CHECK_EQUAL(tree.Find(ComponentTree::Root, Native("a")), a);
+    CHECK_EQUAL(tree.Find(ComponentTree::Root, Native("y")), ComponentTree::Root);
+}
+
+static void TestRelease()
+{
+    ComponentTree tree;
+    auto ab = tree.Intern("a/b");
+    auto a = tree.Parent(ab);
+
+    // Only leaves can be released
+    CHECK(!tree.Release(a));
+    CHECK(!tree.Release(ComponentTree::Root));
+    CHECK(tree.Release(ab));
+    CHECK_EQUAL(tree.Find(a, Native("b")), ComponentTree::Root);
+    CHECK(tree.Release(a));
+
+    // Released ids are reused rather than growing the tree
+    size_t size = tree.Size();
+    auto cd = tree.Intern("c/d");
+    CHECK_EQUAL(tree.Size(), size);
+    CHECK(cd == a || cd == ab);
+    CHECK_EQUAL(tree.Path(cd), std::filesystem::path("c/d"));
+    CHECK_EQUAL(tree.Find(ComponentTree::Root, Native("a")), ComponentTree::Root);
+}
+
+static void TestManyNodes()
+{
+    // Enough nodes to grow the index several times, with releases and renames
+    // along the way to compact the arena
+    ComponentTree tree;
+    std::vector<ComponentTree::NodeId> nodes;
+    std::string padding(100, 'p');
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto path = "d" + std::to_string(i % 50) + "/" + padding + std::to_string(i);
+        nodes.push_back(tree.Intern(path));
+    }
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (i % 4 != 1)
+        {
+            CHECK(tree.Release(nodes[i]));
+        }
+        else
+        {
+            tree.Rename(nodes[i], Native(("r" + std::to_string(i)).c_str()));
+        }
+    }
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto dir = tree.Find(ComponentTree::Root, Native(("d" + std::to_string(i % 50)).c_str()));
+        auto found = tree.Find(dir, Native((padding + std::to_string(i)).c_str()));
+        if (i % 4 != 1)
+        {
+            CHECK_EQUAL(found, ComponentTree::Root);
+        }
+        else
+        {
+            CHECK_EQUAL(found, nodes[i]);
+            auto expected = "d" + std::to_string(i % 50) + "/r" + std::to_string(i);
+            CHECK_EQUAL(tree.Path(found), std::filesystem::path(expected));
+        }
+    }
+}
+
+int main()
+{
+    TestIntern();
+    TestUnrenameableComponents();
+    TestRename();
+    TestRelease();
+    TestManyNodes();
+    return CheckResult();
+}
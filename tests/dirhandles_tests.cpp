@@ -0,0 +1,116 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <filesystem>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "componenttree.h"
+#include "dirhandles.h"
+
+using namespace AsciiRename;
+
+// Whether fd is open on the directory now at path
+static bool IsOpenOn(int fd, const std::filesystem::path &path)
+{
+    struct stat fdStat;
+    struct stat pathStat;
+    return fd >= 0 && fstat(fd, &fdStat) == 0 && stat(path.c_str(), &pathStat) == 0 &&
+           fdStat.st_dev == pathStat.st_dev && fdStat.st_ino == pathStat.st_ino;
+}
+
+// Acquires and releases each of count sibling directories, so the handles compete for room
+static void Churn(DirectoryHandles &handles, ComponentTree &tree, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        auto node = tree.Intern(ComponentTree::Root, "d" + std::to_string(i));
+        CHECK(handles.Acquire(tree, node) >= 0);
+        handles.Release(node);
+    }
+}
+
+// The tests run from inside base, so the root's AT_FDCWD is base
+static void MakeTree(const std::filesystem::path &base)
+{
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "a" / "b" / "c");
+    for (int i = 0; i < 5; ++i)
+    {
+        std::filesystem::create_directories(base / ("d" + std::to_string(i)));
+    }
+    CHECK_EQUAL(chdir(base.c_str()), 0);
+}
+
+static void TestPinnedHandleIsNeverEvicted(const std::filesystem::path &base)
+{
+    MakeTree(base);
+
+    ComponentTree tree;
+    DirectoryHandles handles(2);
+    auto a = tree.Intern(ComponentTree::Root, "a");
+    int fd = handles.Acquire(tree, a);
+    CHECK(IsOpenOn(fd, "a"));
+
+    // Moved behind the tree's back, so a handle reopened by name would fail
+    std::filesystem::rename("a", "a-moved");
+    Churn(handles, tree, 5);
+
+    // Forgetting a pinned handle leaves it open too
+    handles.Forget(a);
+    CHECK(IsOpenOn(fd, "a-moved"));
+    CHECK_EQUAL(handles.Acquire(tree, a), fd);
+    handles.Release(a);
+    handles.Release(a);
+
+    // Once released it's evicted like any other, and reopening it by name now fails
+    Churn(handles, tree, 5);
+    CHECK_EQUAL(handles.Acquire(tree, a), -1);
+}
+
+static void TestEvictedParentReopensFromItsParent(const std::filesystem::path &base)
+{
+    MakeTree(base);
+
+    ComponentTree tree;
+    DirectoryHandles handles(3);
+    auto a = tree.Intern(ComponentTree::Root, "a");
+    auto b = tree.Intern(a, "b");
+    auto c = tree.Intern(b, "c");
+
+    int aFd = handles.Acquire(tree, a);
+    CHECK(IsOpenOn(aFd, "a"));
+    CHECK(IsOpenOn(handles.Acquire(tree, c), "a/b/c"));
+    handles.Release(c);
+
+    // With a pinned, making room closes c and then b, leaving a open
+    Churn(handles, tree, 2);
+
+    // Only a's own handle knows where it went, so b must be reopened through it
+    std::filesystem::rename("a", "a-moved");
+    int cFd = handles.Acquire(tree, c);
+    CHECK(IsOpenOn(cFd, "a-moved/b/c"));
+    CHECK(IsOpenOn(handles.Acquire(tree, b), "a-moved/b"));
+    CHECK(IsOpenOn(aFd, "a-moved"));
+    handles.Release(b);
+    handles.Release(c);
+    handles.Release(a);
+}
+
+int main()
+{
+    auto base = std::filesystem::temp_directory_path() /
+                ("ascii-rename-dirhandles-test-" + std::to_string(static_cast<long>(getpid())));
+    auto cwd = std::filesystem::current_path();
+
+    TestPinnedHandleIsNeverEvicted(base);
+    TestEvictedParentReopensFromItsParent(base);
+
+    std::filesystem::current_path(cwd);
+    std::filesystem::remove_all(base);
+    return CheckResult();
+}
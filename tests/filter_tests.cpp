@@ -0,0 +1,144 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include "check.h"
+#include "filter.h"
+
+using namespace AsciiRename;
+
+static bool GlobMatches(const char *pattern, const char *name)
+{
+    return Glob(pattern).Matches(name);
+}
+
+static void TestLiteralsAndStars()
+{
+    CHECK(GlobMatches("abc", "abc"));
+    CHECK(!GlobMatches("abc", "abcd"));
+    CHECK(!GlobMatches("abc", "ab"));
+    CHECK(GlobMatches("*", ""));
+    CHECK(GlobMatches("*", "anything"));
+    CHECK(GlobMatches("a*", "a"));
+    CHECK(GlobMatches("*c", "abc"));
+    CHECK(GlobMatches("a**c", "abc"));
+
+    // The last star has to give back characters for the rest to match
+    CHECK(GlobMatches("*ab", "aaab"));
+    CHECK(GlobMatches("a*b*c", "axxbyybzzc"));
+    CHECK(GlobMatches("*.tar.*", "x.tar.tar.gz"));
+    CHECK(!GlobMatches("a*b*c", "axxbyyb"));
+    CHECK(!GlobMatches("*ab", "aaba"));
+
+    // Escapes make glob syntax literal
+    CHECK(GlobMatches("\\*", "*"));
+    CHECK(!GlobMatches("\\*", "a"));
+    CHECK(GlobMatches("a\\?", "a?"));
+}
+
+static void TestAnyChar()
+{
+    CHECK(GlobMatches("?", "a"));
+    CHECK(!GlobMatches("?", ""));
+    CHECK(!GlobMatches("?", "ab"));
+
+    // ? is one character, however many bytes it takes
+    CHECK(GlobMatches("?.txt", "\xC3\xA9.txt"));
+    CHECK(GlobMatches("a?b", "a\xE2\x82\xAC" "b"));
+    CHECK(!GlobMatches("??.txt", "\xC3\xA9.txt"));
+    CHECK(GlobMatches("*?", "\xF0\x9F\x98\x80"));
+}
+
+static void TestClasses()
+{
+    CHECK(GlobMatches("[abc]", "b"));
+    CHECK(!GlobMatches("[abc]", "d"));
+    CHECK(GlobMatches("[a-c]x", "cx"));
+    CHECK(!GlobMatches("[a-c]x", "dx"));
+    CHECK(GlobMatches("[!a-c]", "d"));
+    CHECK(GlobMatches("[^a-c]", "d"));
+    CHECK(!GlobMatches("[!a-c]", "a"));
+    CHECK(GlobMatches("[]]", "]"));
+    CHECK(GlobMatches("[a-]", "-"));
+
+    // An unclosed [ is a literal
+    CHECK(GlobMatches("[ab", "[ab"));
+
+    // Non-ASCII members are whole characters: [éè] is two members, not four bytes
+    CHECK(GlobMatches("caf[\xC3\xA9\xC3\xA8]", "caf\xC3\xA9"));
+    CHECK(GlobMatches("caf[\xC3\xA9\xC3\xA8]", "caf\xC3\xA8"));
+    CHECK(!GlobMatches("caf[\xC3\xA9\xC3\xA8]", "caf\xC3\xAA"));
+    CHECK(!GlobMatches("[\xC3\xA9\xC3\xA8]", "\xC3"));
+    CHECK(!GlobMatches("[\xC3\xA9\xC3\xA8]*", "\xA9x"));
+    CHECK(GlobMatches("[!\xC3\xA9]", "\xC3\xA8"));
+    CHECK(!GlobMatches("[!\xC3\xA9]", "\xC3\xA9"));
+
+    // Ranges are by code point, across ASCII and beyond it
+    CHECK(GlobMatches("[\xD0\xB0-\xD1\x8F]", "\xD0\xB6"));
+    CHECK(!GlobMatches("[\xD0\xB0-\xD1\x8F]", "\xD0\x96"));
+    CHECK(GlobMatches("[a-\xC3\xBF]", "z"));
+    CHECK(GlobMatches("[a-\xC3\xBF]", "\xC3\xBC"));
+    CHECK(!GlobMatches("[a-\xC3\xBF]", "A"));
+
+    // A stray byte isn't any character, so only a negated class takes it
+    CHECK(!GlobMatches("[\xC3\xA9]", "\xE9"));
+    CHECK(GlobMatches("[!a]", "\xE9"));
+}
+
+static void TestGlobSet()
+{
+    GlobSet set;
+    CHECK(set.Empty());
+    CHECK(!set.Matches("a.txt"));
+
+    set.Add("*.txt");
+    set.Add("Thumbs.db");
+    set.Add("*.tar.gz");
+    set.Add("data[0-9]");
+    CHECK(!set.Empty());
+
+    // "*.ext" and plain names are looked up, the rest are matched as globs
+    CHECK(set.Matches("a.txt"));
+    CHECK(set.Matches(".txt"));
+    CHECK(set.Matches("a.b.txt"));
+    CHECK(!set.Matches("a.txt.bak"));
+    CHECK(!set.Matches("txt"));
+    CHECK(set.Matches("Thumbs.db"));
+    CHECK(!set.Matches("thumbs.db"));
+    CHECK(set.Matches("x.tar.gz"));
+    CHECK(!set.Matches("x.gz"));
+    CHECK(set.Matches("data7"));
+    CHECK(!set.Matches("data"));
+}
+
+static void TestNameFilter()
+{
+    NameFilter filter;
+    CHECK(filter.Empty());
+    CHECK(!filter.Prunes("a.txt"));
+    CHECK(!filter.SkipsFile("a.txt"));
+
+    filter.Include.Add("*.mp3");
+    filter.Include.Add("*.flac");
+    CHECK(!filter.Empty());
+    CHECK(!filter.SkipsFile("song.mp3"));
+    CHECK(filter.SkipsFile("cover.jpg"));
+
+    // Includes only apply to files; nothing is pruned until there's an exclude
+    CHECK(!filter.Prunes("cover.jpg"));
+
+    // An exclude wins over an include, since it's applied first
+    filter.Exclude.Add("demo*");
+    CHECK(filter.Prunes("demo.mp3"));
+    CHECK(!filter.Prunes("song.mp3"));
+    CHECK(!filter.SkipsFile("song.mp3"));
+}
+
+int main()
+{
+    TestLiteralsAndStars();
+    TestAnyChar();
+    TestClasses();
+    TestGlobSet();
+    TestNameFilter();
+    return CheckResult();
+}
@@ -0,0 +1,425 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "anyascii.h"
+#include "check.h"
+#include "helpers.h"
+#include "utf8.h"
+
+using namespace AsciiRename;
+
+static bool ScalarIsAscii(std::string_view input)
+{
+    for (char c : input)
+    {
+        if (static_cast<unsigned char>(c) >= 0x80)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Lengths and offsets that hit the 32- and 16-byte blocks, the 8-byte words and the
+// byte-at-a-time tail, from unaligned starts
+static void TestIsAscii()
+{
+    std::string buffer(160, 'a');
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = static_cast<char>(0x20 + i % 0x5F);
+    }
+
+    for (size_t start = 0; start < 4; ++start)
+    {
+        for (size_t length = 0; start + length <= 100; ++length)
+        {
+            std::string_view input(buffer.data() + start, length);
+            CHECK(IsAscii(input));
+
+            // Each position in turn holds the one non-ASCII byte
+            for (size_t bad = 0; bad < length; ++bad)
+            {
+                for (unsigned char c : {0x80, 0xC3, 0xFF})
+                {
+                    char saved = buffer[start + bad];
+                    buffer[start + bad] = static_cast<char>(c);
+                    CHECK_EQUAL(IsAscii(input), ScalarIsAscii(input));
+                    buffer[start + bad] = saved;
+                }
+            }
+        }
+    }
+
+    CHECK(IsAscii("plain name.txt"));
+    CHECK(!IsAscii("caf\xC3\xA9"));
+}
+
+static bool IsShellMetachar(unsigned char c)
+{
+    return c != 0 && std::strchr(";$`|&><'\"\\*?[]()!~#\n\r", c) != nullptr;
+}
+
+// Every byte value at every position of inputs that span whole vectors and the tail
+static void TestShellMetachars()
+{
+    std::string clean(40, 'x');
+    for (size_t i = 0; i < clean.size(); ++i)
+    {
+        clean[i] = "abcXYZ019 ._-+=,@%^{}"[i % 21];
+    }
+    CHECK(!NeedsRename(clean));
+
+    for (size_t length : {1u, 15u, 16u, 17u, 33u, 40u})
+    {
+        for (size_t position = 0; position < length; ++position)
+        {
+            for (unsigned c = 1; c < 256; ++c)
+            {
+                std::string input = clean.substr(0, length);
+                input[position] = static_cast<char>(c);
+                bool metachar = IsShellMetachar(static_cast<unsigned char>(c));
+
+                CHECK_EQUAL(NeedsRename(input), metachar || c >= 0x80);
+
+                std::string expected = input;
+                if (metachar)
+                {
+                    expected[position] = '_';
+                }
+                CHECK_EQUAL(SanitizeForShell(input), expected);
+                CHECK_EQUAL(SanitizeForShellInPlace(input.data(), input.size()), metachar ? 1u : 0u);
+                CHECK_EQUAL(input, expected);
+            }
+        }
+    }
+
+    // Several metacharacters, in and across vector blocks
+    std::string input = "a;b$c`d|e&f>g<h'i\"j\\k*l?m[n]o(p)q!r~s#t\nu\rv";
+    std::string expected = "a_b_c_d_e_f_g_h_i_j_k_l_m_n_o_p_q_r_s_t_u_v";
+    CHECK_EQUAL(SanitizeForShellInPlace(input.data(), input.size()), 21u);
+    CHECK_EQUAL(input, expected);
+    CHECK_EQUAL(SanitizeForShell(std::string("x(1).mp3")), "x_1_.mp3");
+}
+
+static void TestTransliterateBatch()
+{
+    std::vector<std::string_view> names{"caf\xC3\xA9", "", "plain", "\xD0\x96\xD1\x83\xD0\xBA", "\xE9\x9F\xB3"};
+    AsciiBatch batch;
+    TransliterateBatch(names.data(), names.size(), batch);
+
+    // Each name matches the one-at-a-time result, packed end to end with no slack
+    CHECK_EQUAL(batch.size(), names.size());
+    size_t total = 0;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        std::string expected;
+        CHECK(TryGetAscii(std::string(names[i]), expected));
+        CHECK_EQUAL(batch[i], expected);
+        CHECK_EQUAL(batch.Offsets[i], total);
+        total += expected.size();
+    }
+    CHECK_EQUAL(batch.Arena.size(), total);
+    CHECK_EQUAL(batch[3], "Zhuk");
+
+    // A batch is replaced, not appended to, when reused
+    std::vector<std::string_view> more{"\xC3\xBC"};
+    TransliterateBatch(more.data(), more.size(), batch);
+    CHECK_EQUAL(batch.size(), 1u);
+    CHECK_EQUAL(batch[0], "u");
+    CHECK_EQUAL(batch.Arena.size(), 1u);
+
+    TransliterateBatch(nullptr, 0, batch);
+    CHECK_EQUAL(batch.size(), 0u);
+    CHECK(batch.Arena.empty());
+}
+
+// Names whose transliterations are longer, shorter and the same length as the input,
+// some with shell metacharacters before and after transliteration
+static const char *const TransliterationSamples[] = {
+    "",
+    "plain.txt",
+    "caf\xC3\xA9 & cr\xC3\xA8me.txt",
+    "Stra\xC3\x9F" "e",
+    "\xE3\x83\x87\xE3\x82\xA3\xE3\x82\xB9\xE3\x82\xAF 1",
+    "\xE2\x80\x9Cquoted\xE2\x80\x9D $(x).mp3",
+    "\xF0\x9F\x98\x80\xF0\x9F\x8E\xB5",
+    "\xE2\x84\xA2\xE2\x85\xAB\xEF\xBC\x81",
+};
+
+// Calls the caller-buffer form with every buffer size up to past the full length and
+// checks the truncation contract against the string form's result
+static void CheckCallerBuffer(size_t (*transliterate)(std::string_view, char *, size_t), std::string_view input,
+                              const std::string &expected)
+{
+    const char unwritten = '\x01';
+    for (size_t size = 0; size <= expected.length() + 2; ++size)
+    {
+        std::vector<char> buffer(size + 8, unwritten);
+        CHECK_EQUAL(transliterate(input, buffer.data(), size), expected.length());
+
+        size_t written = std::min(size, expected.length());
+        CHECK_EQUAL(std::string(buffer.data(), written), expected.substr(0, written));
+        CHECK(std::count(buffer.begin() + written, buffer.end(), unwritten) ==
+              static_cast<std::ptrdiff_t>(buffer.size() - written));
+    }
+}
+
+static void TestCallerBufferContract()
+{
+    for (const char *sample : TransliterationSamples)
+    {
+        std::string expected;
+        CHECK(TryGetAscii(sample, expected));
+        CheckCallerBuffer(TryGetAscii, sample, expected);
+    }
+}
+
+static void TestFusedSanitize()
+{
+    for (const char *sample : TransliterationSamples)
+    {
+        std::string ascii;
+        CHECK(TryGetAscii(sample, ascii));
+        std::string expected = SanitizeForShell(ascii);
+
+        std::string fused;
+        CHECK(TryGetSanitizedAscii(sample, fused));
+        CHECK_EQUAL(fused, expected);
+        CheckCallerBuffer(TryGetSanitizedAscii, sample, expected);
+    }
+}
+
+static void TestMeasuring()
+{
+    for (const char *sample : TransliterationSamples)
+    {
+        std::string expected;
+        CHECK(TryGetAscii(sample, expected));
+        CHECK_EQUAL(TryGetAscii(sample, nullptr, 0), expected.length());
+        CHECK_EQUAL(TryGetSanitizedAscii(sample, nullptr, 0), expected.length());
+
+        // The measured size is enough for the whole result in one call
+        std::vector<char> buffer(TryGetAscii(sample, nullptr, 0));
+        CHECK_EQUAL(TryGetAscii(sample, buffer.data(), buffer.size()), buffer.size());
+        CHECK_EQUAL(std::string(buffer.begin(), buffer.end()), expected);
+    }
+}
+
+// Looks name up in the cache and checks it against the uncached conversion
+static void CheckCached(TransliterationCache &cache, const std::string &name, size_t hits, size_t misses)
+{
+    std::string expected;
+    CHECK(TryGetSanitizedAscii(name, expected));
+    std::string output;
+    CHECK(cache.TryGetSanitizedAscii(name, output));
+    CHECK_EQUAL(output, expected);
+    CHECK_EQUAL(cache.Hits(), hits);
+    CHECK_EQUAL(cache.Misses(), misses);
+}
+
+static void TestTransliterationCache()
+{
+    TransliterationCache cache(2);
+
+    // Pure ASCII never touches the cache, but is still sanitized
+    CheckCached(cache, "a&b.txt", 0, 0);
+
+    CheckCached(cache, "caf\xC3\xA9", 0, 1);
+    CheckCached(cache, "caf\xC3\xA9", 1, 1);
+    CheckCached(cache, "\xC3\xBC & \xC3\xB6", 1, 2);
+    CheckCached(cache, "\xC3\xBC & \xC3\xB6", 2, 2);
+    CheckCached(cache, "caf\xC3\xA9", 3, 2);
+
+    // Full, so the third name clears both of the others out
+    CheckCached(cache, "\xD0\x90\xD0\xB1", 3, 3);
+    CheckCached(cache, "\xD0\x90\xD0\xB1", 4, 3);
+    CheckCached(cache, "caf\xC3\xA9", 4, 4);
+    CheckCached(cache, "\xC3\xBC & \xC3\xB6", 4, 5);
+
+    // ...and the one it cleared for is gone again once it fills up a second time
+    CheckCached(cache, "\xD0\x90\xD0\xB1", 4, 6);
+    CheckCached(cache, "a&b.txt", 4, 6);
+}
+
+// Transliterates utf8 with one cache lookup per non-ASCII codepoint and returns the
+// calling thread's hits and misses since start
+static CodepointCacheStats LookUp(std::string_view utf8, const CodepointCacheStats &start)
+{
+    TryGetAscii(utf8, nullptr, 0);
+    auto now = GetCodepointCacheStats();
+    return {now.Hits - start.Hits, now.Misses - start.Misses};
+}
+
+static void CheckStats(const CodepointCacheStats &stats, uint64_t hits, uint64_t misses)
+{
+    CHECK_EQUAL(stats.Hits, hits);
+    CHECK_EQUAL(stats.Misses, misses);
+}
+
+static void TestCodepointCache()
+{
+    auto before = GetCodepointCacheStats();
+    CodepointCacheStats counted = {};
+
+    // A new thread starts with an empty cache
+    std::thread worker([&] {
+        auto start = GetCodepointCacheStats();
+
+        CheckStats(LookUp("\xC3\xA9", start), 0, 1);
+        CheckStats(LookUp("\xC3\xA9\xC3\xA9", start), 2, 1);
+
+        // ASCII is copied through without a lookup
+        CheckStats(LookUp("plain ASCII", start), 2, 1);
+
+        // Transliterations too long for an entry are never cached
+        CheckStats(LookUp("\xEF\xB7\xBA", start), 2, 2);
+        CheckStats(LookUp("\xEF\xB7\xBA", start), 2, 3);
+
+        // Find a codepoint that takes e-acute's place, then check they displace each other
+        std::string displacing;
+        for (uint32_t cp = 0x4E00; cp < 0x9FFF && displacing.empty(); ++cp)
+        {
+            std::string candidate = {static_cast<char>(0xE0 | (cp >> 12)), static_cast<char>(0x80 | ((cp >> 6) & 0x3F)),
+                                     static_cast<char>(0x80 | (cp & 0x3F))};
+            auto seen = LookUp("\xC3\xA9", start);
+            if (LookUp(candidate, start).Misses == seen.Misses + 1 &&
+                LookUp("\xC3\xA9", start).Misses == seen.Misses + 2)
+            {
+                displacing = candidate;
+            }
+        }
+        CHECK(!displacing.empty());
+
+        auto seen = LookUp("", start);
+        CheckStats(LookUp(displacing, start), seen.Hits, seen.Misses + 1);
+        CheckStats(LookUp(displacing, start), seen.Hits + 1, seen.Misses + 1);
+        CheckStats(LookUp("\xC3\xA9", start), seen.Hits + 1, seen.Misses + 2);
+        counted = LookUp("", start);
+    });
+    worker.join();
+
+    // The thread's counts outlive it
+    auto after = GetCodepointCacheStats();
+    CheckStats({after.Hits - before.Hits, after.Misses - before.Misses}, counted.Hits, counted.Misses);
+}
+
+// The byte-at-a-time utf8_decode loop the vectorized decoder replaced
+static std::string ReferenceAscii(std::string_view input)
+{
+    std::string output;
+    uint32_t utf32;
+    uint32_t state = UTF8_ACCEPT;
+    for (char c : input)
+    {
+        utf8_decode(&state, &utf32, static_cast<unsigned char>(c));
+        if (state == UTF8_ACCEPT)
+        {
+            const char *r;
+            size_t rlen = anyascii(utf32, &r);
+            output.append(r, rlen);
+        }
+        else if (state == UTF8_REJECT)
+        {
+            state = UTF8_ACCEPT;
+        }
+    }
+    return output;
+}
+
+static void CheckAgainstReference(const std::string &input)
+{
+    std::string expected = ReferenceAscii(input);
+    std::string actual;
+    CHECK(TryGetAscii(input, actual));
+    CHECK_EQUAL(actual, expected);
+    CHECK_EQUAL(TryGetAscii(std::string_view(input), nullptr, 0), expected.length());
+}
+
+static void TestDecodeAgainstReference()
+{
+    const char *sequences[] = {
+        "\xC3\xBC",               // Valid two-byte
+        "\xE3\x83\x87",           // Valid three-byte
+        "\xF0\x9F\x98\x80",       // Valid four-byte
+        "\xC3",                   // Truncated
+        "\xE3\x83",               // Truncated
+        "\xF0\x9F\x98",           // Truncated
+        "\xC0\xAF",               // Overlong
+        "\xC1\xBF",               // Overlong
+        "\xE0\x80\xAF",           // Overlong
+        "\xE0\x9F\xBF",           // Overlong
+        "\xF0\x80\x80\xAF",       // Overlong
+        "\xF0\x8F\xBF\xBF",       // Overlong
+        "\xED\xA0\x80",           // Surrogate
+        "\xED\xBF\xBF",           // Surrogate
+        "\xF4\x90\x80\x80",       // Above U+10FFFF
+        "\xF5\x80\x80\x80",       // Above U+10FFFF
+        "\xFF",                   // Never valid
+        "\x80",                   // Stray continuation
+        "\xBF\xBF",               // Stray continuations
+        "\xC3\xBC\xBC",           // Valid then stray continuation
+        "\xE3\x41",               // Broken by ASCII, which is dropped with it
+        "\xF0\x9F\xC3\xBC",       // Broken by a new lead byte
+    };
+
+    // Place each sequence at every offset across the 16 and 32 byte vector boundaries,
+    // both with ASCII after it and at the very end of the input
+    for (const char *sequence : sequences)
+    {
+        for (size_t offset = 0; offset <= 40; ++offset)
+        {
+            std::string input = std::string(offset, 'a') + sequence;
+            CheckAgainstReference(input);
+            CheckAgainstReference(input + std::string(40, 'b'));
+        }
+    }
+
+    // Pairs of sequences back to back, straddling a boundary
+    for (const char *first : sequences)
+    {
+        for (const char *second : sequences)
+        {
+            for (size_t offset = 12; offset <= 33; ++offset)
+            {
+                CheckAgainstReference(std::string(offset, 'a') + first + second + "z");
+            }
+        }
+    }
+
+    // Random bytes, biased towards the interesting range
+    uint32_t seed = 12345;
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string input;
+        size_t length = i % 70;
+        for (size_t j = 0; j < length; ++j)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned char c = static_cast<unsigned char>(seed >> 24);
+            input.push_back(static_cast<char>((seed & 0x100) ? c : (c | 0x80)));
+        }
+        CheckAgainstReference(input);
+    }
+}
+
+int main()
+{
+    TestIsAscii();
+    TestShellMetachars();
+    TestTransliterateBatch();
+    TestCallerBufferContract();
+    TestFusedSanitize();
+    TestTransliterationCache();
+    TestCodepointCache();
+    TestMeasuring();
+    TestDecodeAgainstReference();
+    return CheckResult();
+}
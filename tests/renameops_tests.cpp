@@ -0,0 +1,79 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include "check.h"
+#include "renameops.h"
+
+using namespace AsciiRename;
+
+static void TestAddDeduplicates()
+{
+    ComponentTree tree;
+    auto a = tree.Intern("a");
+    auto b = tree.Intern("a/b");
+
+    RenameOpSet ops;
+    CHECK(!ops.Contains(a));
+    ops.Add(a);
+    ops.Add(b);
+    ops.Add(a);
+    ops.Add(b);
+    CHECK_EQUAL(ops.size(), 2u);
+    CHECK(ops.Contains(a));
+    CHECK(ops.Contains(b));
+    CHECK(!ops.Contains(tree.Intern("c")));
+}
+
+static void TestTakeDeepestFirst()
+{
+    ComponentTree tree;
+    auto a = tree.Intern("a");
+    auto ab = tree.Intern("a/b");
+    auto abc = tree.Intern("a/b/c");
+    auto d = tree.Intern("d");
+    auto de = tree.Intern("d/e");
+    auto abf = tree.Intern("a/b/f");
+
+    RenameOpSet ops;
+    for (auto op : {a, de, abc, d, ab, abf, de, a})
+    {
+        ops.Add(op);
+    }
+
+    // Deepest first; the same depth in the order first added
+    auto sorted = ops.TakeDeepestFirst(tree);
+    std::vector<RenameOp> expected{abc, abf, de, ab, a, d};
+    CHECK(sorted == expected);
+
+    // Taking the ops empties the set, so the next batch starts fresh
+    CHECK_EQUAL(ops.size(), 0u);
+    CHECK(!ops.Contains(a));
+    CHECK(ops.TakeDeepestFirst(tree).empty());
+    ops.Add(a);
+    CHECK_EQUAL(ops.size(), 1u);
+}
+
+static void TestDepthSkipsUnrenameableComponents()
+{
+    // The root and . don't count toward depth, so these sort together
+    ComponentTree tree;
+    auto x = tree.Intern("/x");
+    auto y = tree.Intern("./y/z");
+    auto w = tree.Intern("w/v");
+
+    RenameOpSet ops;
+    ops.Add(x);
+    ops.Add(y);
+    ops.Add(w);
+    auto sorted = ops.TakeDeepestFirst(tree);
+    std::vector<RenameOp> expected{y, w, x};
+    CHECK(sorted == expected);
+}
+
+int main()
+{
+    TestAddDeduplicates();
+    TestTakeDeepestFirst();
+    TestDepthSkipsUnrenameableComponents();
+    return CheckResult();
+}
@@ -0,0 +1,245 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "scancache.h"
+#include "walker.h"
+
+using namespace AsciiRename;
+
+// A directory's stat as the cache sees it, modified an hour before the test
+static struct stat DirectoryStat(ino_t ino, long mtimeNsec = 0, long ctimeNsec = 0)
+{
+    struct stat st = {};
+    st.st_dev = 1;
+    st.st_ino = ino;
+    st.st_mtim.tv_sec = std::time(nullptr) - 3600;
+    st.st_mtim.tv_nsec = mtimeNsec;
+    st.st_ctim.tv_sec = st.st_mtim.tv_sec;
+    st.st_ctim.tv_nsec = ctimeNsec;
+    return st;
+}
+
+static std::vector<std::string> Lookup(ScanCache &cache, const struct stat &st, bool &found)
+{
+    std::vector<std::string_view> names;
+    found = cache.TryGetCleanSubdirectories(st, names);
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+static bool IsClean(ScanCache &cache, const struct stat &st)
+{
+    bool found;
+    Lookup(cache, st, found);
+    return found;
+}
+
+static void TestMissingAndInvalidFiles(std::filesystem::path const &path)
+{
+    std::filesystem::remove(path);
+    {
+        ScanCache cache(path, true);
+        CHECK_EQUAL(cache.Size(), 0u);
+        CHECK(!IsClean(cache, DirectoryStat(10)));
+    }
+
+    std::ofstream(path) << "not a scan cache, just some text long enough to have a header";
+    {
+        ScanCache cache(path, true);
+        CHECK_EQUAL(cache.Size(), 0u);
+    }
+}
+
+static void TestRoundTrip(std::filesystem::path const &path)
+{
+    std::filesystem::remove(path);
+    {
+        ScanCache cache(path, true);
+        cache.RecordClean(DirectoryStat(10), {"x", "yy"});
+        cache.RecordClean(DirectoryStat(20), {});
+        cache.RecordClean(DirectoryStat(10), {"x", "yy"});
+        CHECK(cache.Save());
+    }
+
+    ScanCache cache(path, true);
+    CHECK_EQUAL(cache.Size(), 2u);
+
+    bool found;
+    auto names = Lookup(cache, DirectoryStat(10), found);
+    CHECK(found);
+    CHECK(names == std::vector<std::string>({"x", "yy"}));
+    names = Lookup(cache, DirectoryStat(20), found);
+    CHECK(found);
+    CHECK(names.empty());
+    CHECK(!IsClean(cache, DirectoryStat(30)));
+}
+
+static void TestRecentDirectoriesAreNotRecorded(std::filesystem::path const &path)
+{
+    std::filesystem::remove(path);
+    {
+        // A change later in the same second wouldn't change the mtime or ctime
+        ScanCache cache(path, true);
+        auto st = DirectoryStat(10);
+        st.st_mtim.tv_sec = std::time(nullptr);
+        cache.RecordClean(st, {});
+        st = DirectoryStat(20);
+        st.st_ctim.tv_sec = std::time(nullptr);
+        cache.RecordClean(st, {});
+        CHECK(cache.Save());
+    }
+
+    ScanCache cache(path, true);
+    CHECK_EQUAL(cache.Size(), 0u);
+}
+
+static void TestInvalidation(std::filesystem::path const &path)
+{
+    std::filesystem::remove(path);
+    {
+        ScanCache cache(path, true);
+        cache.RecordClean(DirectoryStat(10), {"a"});
+        cache.RecordClean(DirectoryStat(20), {"b"});
+        cache.RecordClean(DirectoryStat(30), {"c"});
+        cache.RecordClean(DirectoryStat(40), {"d"});
+        CHECK(cache.Save());
+    }
+
+    {
+        ScanCache cache(path, true);
+        CHECK_EQUAL(cache.Size(), 4u);
+
+        // A changed mtime or ctime means the names may have changed, e.g. the mtime
+        // set back after adding an entry
+        CHECK(!IsClean(cache, DirectoryStat(10, 1, 0)));
+        CHECK(!IsClean(cache, DirectoryStat(20, 0, 1)));
+
+        // Found clean again, with a new subdirectory
+        CHECK(IsClean(cache, DirectoryStat(30)));
+        cache.RecordClean(DirectoryStat(30, 5, 5), {"c", "e"});
+
+        // 40 isn't visited at all, as in a run on another root
+        CHECK(cache.Save());
+    }
+
+    ScanCache cache(path, true);
+    CHECK_EQUAL(cache.Size(), 2u);
+    CHECK(!IsClean(cache, DirectoryStat(10)));
+    CHECK(!IsClean(cache, DirectoryStat(10, 1, 0)));
+    CHECK(!IsClean(cache, DirectoryStat(20, 0, 1)));
+    CHECK(!IsClean(cache, DirectoryStat(30)));
+
+    bool found;
+    auto names = Lookup(cache, DirectoryStat(30, 5, 5), found);
+    CHECK(found);
+    CHECK(names == std::vector<std::string>({"c", "e"}));
+    names = Lookup(cache, DirectoryStat(40), found);
+    CHECK(found);
+    CHECK(names == std::vector<std::string>({"d"}));
+}
+
+static void TestFollowModeMismatch(std::filesystem::path const &path)
+{
+    std::filesystem::remove(path);
+    {
+        ScanCache cache(path, false);
+        cache.RecordClean(DirectoryStat(10), {"a"});
+        CHECK(cache.Save());
+    }
+
+    // Records that left out symlinked directories can't stand in for a listing that
+    // follows them, nor the other way around
+    {
+        ScanCache cache(path, true);
+        CHECK_EQUAL(cache.Size(), 0u);
+        CHECK(!IsClean(cache, DirectoryStat(10)));
+        cache.RecordClean(DirectoryStat(20), {"b"});
+        CHECK(cache.Save());
+    }
+    {
+        ScanCache cache(path, false);
+        CHECK_EQUAL(cache.Size(), 0u);
+    }
+
+    ScanCache cache(path, true);
+    CHECK_EQUAL(cache.Size(), 1u);
+    CHECK(IsClean(cache, DirectoryStat(20)));
+}
+
+// Walks root with the cache and returns the names of every entry found
+static std::vector<std::string> WalkNames(std::filesystem::path const &root, std::filesystem::path const &path,
+                                          bool followSymlinks)
+{
+    ScanCache cache(path, followSymlinks);
+    WalkOptions options;
+    options.FollowSymlinks = followSymlinks;
+    options.Cache = &cache;
+
+    std::vector<std::string> names;
+    DirectoryWalker(options).Walk(root, [&](std::filesystem::path const &, std::vector<WalkEntry> &entries) {
+        for (auto const &entry : entries)
+        {
+            names.push_back(entry.Path.filename().string());
+        }
+    });
+    CHECK(cache.Save());
+    return names;
+}
+
+static bool Contains(std::vector<std::string> const &names, std::string const &name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// A run that doesn't follow symlinks records root as clean with no subdirectories; a
+// later run that does must still go through the link
+static void TestSymlinkedDirectoryAfterNoFollowRun(std::filesystem::path const &path)
+{
+    auto base = std::filesystem::path(path.string() + ".tree");
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "root");
+    std::filesystem::create_directories(base / "target");
+    std::ofstream(base / "target" / "\xC3\xA9.txt").close();
+    std::filesystem::create_directory_symlink("../target", base / "root" / "link");
+
+    // Directories changed in the current second aren't recorded
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    std::filesystem::remove(path);
+    auto names = WalkNames(base / "root", path, false);
+    CHECK(Contains(names, "link"));
+    CHECK(!Contains(names, "\xC3\xA9.txt"));
+
+    names = WalkNames(base / "root", path, true);
+    CHECK(Contains(names, "\xC3\xA9.txt"));
+
+    std::filesystem::remove_all(base);
+}
+
+int main()
+{
+    auto path = std::filesystem::temp_directory_path() /
+                ("ascii-rename-scancache-test-" + std::to_string(static_cast<long>(getpid())));
+
+    TestMissingAndInvalidFiles(path);
+    TestRoundTrip(path);
+    TestRecentDirectoriesAreNotRecorded(path);
+    TestInvalidation(path);
+    TestFollowModeMismatch(path);
+    TestSymlinkedDirectoryAfterNoFollowRun(path);
+
+    std::filesystem::remove(path);
+    return CheckResult();
+}
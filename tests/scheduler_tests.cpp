@@ -0,0 +1,152 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "scheduler.h"
+
+using namespace AsciiRename;
+
+// When each op started and finished, as positions in one sequence of events
+struct OpTimes
+{
+    int Runs = 0;
+    size_t Start = 0;
+    size_t Finish = 0;
+};
+
+static bool IsBelow(ComponentTree const &tree, ComponentTree::NodeId node, ComponentTree::NodeId ancestor)
+{
+    for (node = tree.Parent(node); node != ComponentTree::Root; node = tree.Parent(node))
+    {
+        if (node == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void TestOrder(unsigned jobs)
+{
+    // Three levels of directories, each with files, all of them ops
+    ComponentTree tree;
+    std::vector<ComponentTree::NodeId> ops;
+    for (int a = 0; a < 4; ++a)
+    {
+        auto dirA = "a" + std::to_string(a);
+        for (int b = 0; b < 4; ++b)
+        {
+            auto dirB = dirA + "/b" + std::to_string(b);
+            for (int f = 0; f < 4; ++f)
+            {
+                ops.push_back(tree.Intern(dirB + "/f" + std::to_string(f)));
+            }
+            ops.push_back(tree.Intern(dirB));
+        }
+        ops.push_back(tree.Intern(dirA));
+    }
+
+    std::mutex lock;
+    size_t clock = 0;
+    std::vector<OpTimes> times(tree.Size());
+    RunInDependencyOrder(tree, ops, jobs, [&](ComponentTree::NodeId op) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++times[op].Runs;
+            times[op].Start = clock++;
+        }
+        std::this_thread::yield();
+        std::lock_guard<std::mutex> guard(lock);
+        times[op].Finish = clock++;
+    });
+
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        auto op = ops[i];
+        CHECK_EQUAL(times[op].Runs, 1);
+        for (size_t j = 0; j < ops.size(); ++j)
+        {
+            auto other = ops[j];
+
+            // Everything below an op finishes before it starts
+            if (IsBelow(tree, other, op))
+            {
+                CHECK(times[other].Finish < times[op].Start);
+            }
+
+            // Entries of one directory run one at a time, in the order given
+            if (j < i && tree.Parent(other) == tree.Parent(op))
+            {
+                CHECK(times[other].Finish < times[op].Start);
+            }
+        }
+    }
+}
+
+static void TestUnrelatedDirectoriesRunInParallel()
+{
+    ComponentTree tree;
+    std::vector<ComponentTree::NodeId> ops{tree.Intern("x/1"), tree.Intern("y/1")};
+
+    // Each op waits for the other to start, which only works if they run at once
+    std::mutex lock;
+    std::condition_variable started;
+    int running = 0;
+    int sawBoth = 0;
+    RunInDependencyOrder(tree, ops, 2, [&](ComponentTree::NodeId) {
+        std::unique_lock<std::mutex> guard(lock);
+        ++running;
+        started.notify_all();
+        if (started.wait_for(guard, std::chrono::seconds(10), [&] { return running == 2; }))
+        {
+            ++sawBoth;
+        }
+    });
+    CHECK_EQUAL(sawBoth, 2);
+}
+
+static void TestSiblingsWaitTheirTurn()
+{
+    // The file is ready at once, but the directory listed before it has to wait for
+    // the slow op below it. The outcome of a collision between the two (e.g. which one
+    // wins with --overwrite) must not depend on that.
+    ComponentTree tree;
+    std::vector<ComponentTree::NodeId> ops{tree.Intern("p/d/slow"), tree.Intern("p/d"), tree.Intern("p/f")};
+
+    std::mutex lock;
+    std::vector<ComponentTree::NodeId> order;
+    RunInDependencyOrder(tree, ops, 4, [&](ComponentTree::NodeId op) {
+        if (op == ops[0])
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        order.push_back(op);
+    });
+    CHECK(order == ops);
+}
+
+static void TestNoOps()
+{
+    ComponentTree tree;
+    int runs = 0;
+    RunInDependencyOrder(tree, {}, 4, [&](ComponentTree::NodeId) { ++runs; });
+    CHECK_EQUAL(runs, 0);
+}
+
+int main()
+{
+    TestOrder(1);
+    TestOrder(8);
+    TestUnrelatedDirectoriesRunInParallel();
+    TestSiblingsWaitTheirTurn();
+    TestNoOps();
+    return CheckResult();
+}
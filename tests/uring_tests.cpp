@@ -0,0 +1,84 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "uring.h"
+
+using namespace AsciiRename;
+
+// Submits everything queued and returns each call's result by user data
+static std::map<uint64_t, int> Complete(IoUring &ring)
+{
+    std::map<uint64_t, int> results;
+    CHECK(ring.SubmitAndWait([&](uint64_t userData, int result) { results[userData] = result; }));
+    return results;
+}
+
+static void TestStatxAndRenameat(IoUring &ring, const std::filesystem::path &path)
+{
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    std::ofstream(path / "caf\xC3\xA9.txt") << "x";
+
+    int dirFd = open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    CHECK(dirFd >= 0);
+
+    struct stat expected;
+    CHECK_EQUAL(stat((path / "caf\xC3\xA9.txt").c_str(), &expected), 0);
+
+    struct statx found = {};
+    struct statx missing = {};
+    ring.QueueStatx(dirFd, "caf\xC3\xA9.txt", 0, STATX_INO, &found, 1);
+    ring.QueueStatx(dirFd, "cafe.txt", 0, STATX_INO, &missing, 2);
+    auto results = Complete(ring);
+    CHECK_EQUAL(results.size(), 2u);
+    CHECK_EQUAL(results[1], 0);
+    CHECK_EQUAL(found.stx_ino, static_cast<uint64_t>(expected.st_ino));
+    CHECK_EQUAL(results[2], -ENOENT);
+
+    ring.QueueRenameat(dirFd, "caf\xC3\xA9.txt", dirFd, "cafe.txt", 0, 3);
+    ring.QueueRenameat(dirFd, "gone.txt", dirFd, "still-gone.txt", 0, 4);
+    results = Complete(ring);
+    CHECK_EQUAL(results.size(), 2u);
+    CHECK_EQUAL(results[3], 0);
+    CHECK_EQUAL(results[4], -ENOENT);
+    CHECK(!std::filesystem::exists(path / "caf\xC3\xA9.txt"));
+    CHECK(std::filesystem::exists(path / "cafe.txt"));
+
+    // The renamed entry is the same file
+    ring.QueueStatx(dirFd, "cafe.txt", 0, STATX_INO, &found, 5);
+    results = Complete(ring);
+    CHECK_EQUAL(results[5], 0);
+    CHECK_EQUAL(found.stx_ino, static_cast<uint64_t>(expected.st_ino));
+    CHECK(!ring.Failed());
+
+    close(dirFd);
+    std::filesystem::remove_all(path);
+}
+
+int main()
+{
+    auto ring = IoUring::TryCreate(8);
+    if (!ring)
+    {
+        std::cerr << "io_uring with statx and renameat isn't available, skipping" << std::endl;
+        return 77;
+    }
+
+    auto path = std::filesystem::temp_directory_path() /
+                ("ascii-rename-uring-test-" + std::to_string(static_cast<long>(getpid())));
+
+    TestStatxAndRenameat(*ring, path);
+    return CheckResult();
+}
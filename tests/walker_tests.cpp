@@ -0,0 +1,215 @@
+// Copyright (c) Jon Thysell <http://jonthysell.com>
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "walker.h"
+
+using namespace AsciiRename;
+
+// What a walk reported: each directory's entries, and the order directories were done in
+struct WalkResult
+{
+    std::map<std::string, std::set<std::string>> Entries;
+    std::vector<std::string> Order;
+};
+
+static WalkResult Walk(std::filesystem::path const &root, WalkOptions const &options)
+{
+    WalkResult result;
+    std::mutex lock;
+    DirectoryWalker(options).Walk(root, [&](std::filesystem::path const &directory, std::vector<WalkEntry> &entries) {
+        std::lock_guard<std::mutex> guard(lock);
+        CHECK_EQUAL(result.Entries.count(directory.string()), 0u);
+        auto &names = result.Entries[directory.string()];
+        for (auto const &entry : entries)
+        {
+            CHECK_EQUAL(entry.Path.parent_path().string(), directory.string());
+            auto status = options.FollowSymlinks ? std::filesystem::status(entry.Path)
+                                                 : std::filesystem::symlink_status(entry.Path);
+            CHECK_EQUAL(entry.IsDirectory, std::filesystem::is_directory(status));
+            names.insert(entry.Path.filename().string());
+        }
+        result.Order.push_back(directory.string());
+    });
+    return result;
+}
+
+// A few levels of directories and files, some with names that need renaming
+static void MakeTree(std::filesystem::path const &base)
+{
+    std::filesystem::remove_all(base);
+    const char *names[] = {"a", "\xD0\x90\xD0\xBB\xD1\x8C\xD0\xB1\xD0\xBE\xD0\xBC", "caf\xC3\xA9", "d"};
+    for (const char *first : names)
+    {
+        for (const char *second : names)
+        {
+            for (const char *third : names)
+            {
+                auto directory = base / first / second / third;
+                std::filesystem::create_directories(directory);
+                std::ofstream(directory / "song.mp3") << "x";
+            }
+            std::ofstream(base / first / second / "\xE3\x83\x87.txt") << "x";
+        }
+    }
+    std::filesystem::create_directories(base / "empty");
+}
+
+static void TestMatchesRecursiveDirectoryIterator(std::filesystem::path const &base)
+{
+    MakeTree(base);
+
+    WalkResult expected;
+    expected.Entries[base.string()];
+    for (auto const &entry : std::filesystem::recursive_directory_iterator(base))
+    {
+        if (entry.is_directory())
+        {
+            expected.Entries[entry.path().string()];
+        }
+        expected.Entries[entry.path().parent_path().string()].insert(entry.path().filename().string());
+    }
+
+    for (unsigned jobs : {1u, 4u})
+    {
+        WalkOptions options;
+        options.Jobs = jobs;
+        auto actual = Walk(base, options);
+        CHECK(actual.Entries == expected.Entries);
+
+        // Post-order: every directory is done before its parent
+        std::map<std::string, size_t> done;
+        for (size_t i = 0; i < actual.Order.size(); ++i)
+        {
+            done[actual.Order[i]] = i;
+        }
+        for (auto const &directory : actual.Order)
+        {
+            if (directory != base.string())
+            {
+                auto parent = done.find(std::filesystem::path(directory).parent_path().string());
+                CHECK(parent != done.end() && parent->second > done[directory]);
+            }
+        }
+    }
+}
+
+static void TestSymlinkCycleEnds(std::filesystem::path const &base)
+{
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "a" / "b");
+    std::filesystem::create_directory_symlink("../..", base / "a" / "b" / "up");
+    std::filesystem::create_directory_symlink(".", base / "a" / "self");
+
+    for (unsigned jobs : {1u, 4u})
+    {
+        WalkOptions options;
+        options.Jobs = jobs;
+        auto result = Walk(base, options);
+
+        // Each real directory is listed once, however many ways there are to reach it.
+        // Other ways in are still reported, but with no entries.
+        std::set<std::filesystem::path> listed;
+        for (auto const &done : result.Entries)
+        {
+            if (!done.second.empty())
+            {
+                CHECK(listed.insert(std::filesystem::canonical(done.first)).second);
+            }
+        }
+        CHECK_EQUAL(listed.size(), 3u);
+        CHECK(result.Entries[(base / "a" / "b").string()].count("up") == 1);
+    }
+}
+
+static void TestNoFollowSkipsSymlinkedDirectories(std::filesystem::path const &base)
+{
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "root");
+    std::filesystem::create_directories(base / "target");
+    std::ofstream(base / "target" / "caf\xC3\xA9.txt") << "x";
+    std::filesystem::create_directory_symlink("../target", base / "root" / "link");
+
+    WalkOptions options;
+    options.FollowSymlinks = false;
+    auto result = Walk(base / "root", options);
+
+    // The link itself is still listed, as an entry that isn't a directory
+    CHECK_EQUAL(result.Entries.size(), 1u);
+    CHECK(result.Entries[(base / "root").string()] == std::set<std::string>{"link"});
+
+    options.FollowSymlinks = true;
+    result = Walk(base / "root", options);
+    CHECK_EQUAL(result.Entries.size(), 2u);
+    CHECK(result.Entries[(base / "root" / "link").string()] == std::set<std::string>{"caf\xC3\xA9.txt"});
+}
+
+static void TestMaxDepth(std::filesystem::path const &base)
+{
+    MakeTree(base);
+
+    // The tree's deepest entries, the song.mp3 files, are 4 levels below the root
+    for (unsigned maxDepth = 1; maxDepth <= 5; ++maxDepth)
+    {
+        for (unsigned jobs : {1u, 4u})
+        {
+            WalkOptions options;
+            options.Jobs = jobs;
+            options.MaxDepth = maxDepth;
+            auto result = Walk(base, options);
+
+            // A directory's entries are one level below it
+            size_t deepest = 0;
+            for (auto const &done : result.Entries)
+            {
+                auto relative = std::filesystem::path(done.first).lexically_relative(base);
+                size_t depth = relative == "." ? 1 : std::distance(relative.begin(), relative.end()) + 1;
+                if (!done.second.empty())
+                {
+                    deepest = std::max(deepest, depth);
+                }
+            }
+            size_t expectedDeepest = std::min(maxDepth, 4u);
+            CHECK_EQUAL(deepest, expectedDeepest);
+
+            // Everything down to the limit is still listed
+            size_t expected = 0;
+            for (auto it = std::filesystem::recursive_directory_iterator(base);
+                 it != std::filesystem::recursive_directory_iterator(); ++it)
+            {
+                expected += static_cast<unsigned>(it.depth()) < maxDepth;
+            }
+            size_t listed = 0;
+            for (auto const &done : result.Entries)
+            {
+                listed += done.second.size();
+            }
+            CHECK_EQUAL(listed, expected);
+        }
+    }
+}
+
+int main()
+{
+    auto base = std::filesystem::temp_directory_path() /
+                ("ascii-rename-walker-test-" + std::to_string(static_cast<long>(getpid())));
+
+    TestMatchesRecursiveDirectoryIterator(base);
+    TestSymlinkCycleEnds(base);
+    TestNoFollowSkipsSymlinkedDirectories(base);
+    TestMaxDepth(base);
+
+    std::filesystem::remove_all(base);
+    return CheckResult();
+}